@@ -0,0 +1,141 @@
+#include <mutex>
+#include "backend.h"
+
+#ifdef HAVE_BLOSC2
+
+// c-blosc2 needs to be initialised once, before it is used
+static void backend_init() {
+  static std::once_flag flag;
+  std::call_once(flag, []() { blosc2_init(); });
+}
+
+int backend_compress(int clevel, int doshuffle, size_t typesize, size_t nbytes,
+                     const void *src, void *dest, size_t destsize,
+                     const char *compressor, size_t blocksize, int nthreads) {
+  backend_init();
+  int compcode = blosc2_compname_to_compcode(compressor);
+  if (compcode < 0) return -1;
+  // c-blosc2 always writes its own chunk format (format version above 2),
+  // which c-blosc cannot read. Hence this backend is only used on request.
+  blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+  cparams.compcode = (uint8_t)compcode;
+  cparams.clevel = (uint8_t)clevel;
+  cparams.typesize = (int32_t)typesize;
+  cparams.blocksize = (int32_t)blocksize;
+  cparams.nthreads = (int16_t)(nthreads < 1 ? 1 : nthreads);
+  cparams.filters[BLOSC2_MAX_FILTERS - 1] = (uint8_t)doshuffle;
+  blosc2_context *ctx = blosc2_create_cctx(cparams);
+  if (ctx == nullptr) return -1;
+  int result = blosc2_compress_ctx(ctx, src, (int32_t)nbytes, dest, (int32_t)destsize);
+  blosc2_free_ctx(ctx);
+  return result;
+}
+
+int backend_decompress(const void *src, size_t srcsize, void *dest, size_t destsize,
+                       int nthreads) {
+  backend_init();
+  blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+  dparams.nthreads = (int16_t)(nthreads < 1 ? 1 : nthreads);
+  blosc2_context *ctx = blosc2_create_dctx(dparams);
+  if (ctx == nullptr) return -1;
+  int result = blosc2_decompress_ctx(ctx, src, (int32_t)srcsize, dest, (int32_t)destsize);
+  blosc2_free_ctx(ctx);
+  return result;
+}
+
+int backend_getitem(const void *src, size_t srcsize, int start, int nitems,
+                    void *dest, size_t destsize) {
+  backend_init();
+  return blosc2_getitem(src, (int32_t)srcsize, start, nitems, dest, (int32_t)destsize);
+}
+
+int backend_cbuffer_validate(const void *src, size_t srcsize, size_t *nbytes) {
+  return blosc1_cbuffer_validate(src, srcsize, nbytes);
+}
+
+void backend_cbuffer_sizes(const void *src, size_t *nbytes, size_t *cbytes,
+                           size_t *blocksize) {
+  int32_t nb = 0, cb = 0, bs = 0;
+  blosc2_cbuffer_sizes(src, &nb, &cb, &bs);
+  *nbytes = (size_t)nb;
+  *cbytes = (size_t)cb;
+  *blocksize = (size_t)bs;
+}
+
+void backend_cbuffer_metainfo(const void *src, size_t *typesize, int *flags) {
+  blosc1_cbuffer_metainfo(src, typesize, flags);
+}
+
+void backend_cbuffer_versions(const void *src, int *version, int *versionlz) {
+  blosc2_cbuffer_versions(src, version, versionlz);
+}
+
+const char *backend_cbuffer_complib(const void *src) {
+  return blosc2_cbuffer_complib(src);
+}
+
+std::string backend_name() {
+  return "c-blosc2";
+}
+
+std::string backend_version() {
+  return blosc2_get_version_string();
+}
+
+std::string backend_list_compressors() {
+  return blosc2_list_compressors();
+}
+
+#else
+
+int backend_compress(int clevel, int doshuffle, size_t typesize, size_t nbytes,
+                     const void *src, void *dest, size_t destsize,
+                     const char *compressor, size_t blocksize, int nthreads) {
+  return blosc_compress_ctx(clevel, doshuffle, typesize, nbytes, src, dest, destsize,
+                            compressor, blocksize, nthreads < 1 ? 1 : nthreads);
+}
+
+int backend_decompress(const void *src, size_t srcsize, void *dest, size_t destsize,
+                       int nthreads) {
+  return blosc_decompress_ctx(src, dest, destsize, nthreads < 1 ? 1 : nthreads);
+}
+
+int backend_getitem(const void *src, size_t srcsize, int start, int nitems,
+                    void *dest, size_t destsize) {
+  return blosc_getitem(src, start, nitems, dest);
+}
+
+int backend_cbuffer_validate(const void *src, size_t srcsize, size_t *nbytes) {
+  return blosc_cbuffer_validate(src, srcsize, nbytes);
+}
+
+void backend_cbuffer_sizes(const void *src, size_t *nbytes, size_t *cbytes,
+                           size_t *blocksize) {
+  blosc_cbuffer_sizes(src, nbytes, cbytes, blocksize);
+}
+
+void backend_cbuffer_metainfo(const void *src, size_t *typesize, int *flags) {
+  blosc_cbuffer_metainfo(src, typesize, flags);
+}
+
+void backend_cbuffer_versions(const void *src, int *version, int *versionlz) {
+  blosc_cbuffer_versions(src, version, versionlz);
+}
+
+const char *backend_cbuffer_complib(const void *src) {
+  return blosc_cbuffer_complib(src);
+}
+
+std::string backend_name() {
+  return "c-blosc";
+}
+
+std::string backend_version() {
+  return blosc_get_version_string();
+}
+
+std::string backend_list_compressors() {
+  return blosc_list_compressors();
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef BLOSC_BACKEND_H
+#define BLOSC_BACKEND_H
+
+#include <string>
+
+// The package is built against either c-blosc (the default) or c-blosc2
+// (when `configure` detects it and defines `HAVE_BLOSC2`). Both produce and
+// read Blosc1 formatted buffers. All other code should call the functions
+// below instead of the library API, such that it works with either backend.
+
+#ifdef HAVE_BLOSC2
+#include <blosc2.h>
+#define BACKEND_MAX_OVERHEAD   BLOSC2_MAX_OVERHEAD
+#define BACKEND_MAX_BUFFERSIZE BLOSC2_MAX_BUFFERSIZE
+#else
+#include "blosc.h"
+#define BACKEND_MAX_OVERHEAD   BLOSC_MAX_OVERHEAD
+#define BACKEND_MAX_BUFFERSIZE BLOSC_MAX_BUFFERSIZE
+#endif
+
+// Functions are thread-safe, and return a negative value on failure
+int backend_compress(int clevel, int doshuffle, size_t typesize, size_t nbytes,
+                     const void *src, void *dest, size_t destsize,
+                     const char *compressor, size_t blocksize, int nthreads);
+int backend_decompress(const void *src, size_t srcsize, void *dest, size_t destsize,
+                       int nthreads);
+int backend_getitem(const void *src, size_t srcsize, int start, int nitems,
+                    void *dest, size_t destsize);
+int backend_cbuffer_validate(const void *src, size_t srcsize, size_t *nbytes);
+void backend_cbuffer_sizes(const void *src, size_t *nbytes, size_t *cbytes,
+                           size_t *blocksize);
+void backend_cbuffer_metainfo(const void *src, size_t *typesize, int *flags);
+void backend_cbuffer_versions(const void *src, int *version, int *versionlz);
+const char *backend_cbuffer_complib(const void *src);
+// Name and (run time) version of the backend library
+std::string backend_name();
+std::string backend_version();
+// Comma separated list of compressors that are compiled into the library
+std::string backend_list_compressors();
+
+#endif /* BLOSC_BACKEND_H */
@@ -0,0 +1,76 @@
+#include <cpp11.hpp>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include "block_cache.h"
+#include "lru.h"
+
+using namespace cpp11;
+
+typedef std::pair<uint64_t, size_t> block_key;
+
+struct block_key_hash {
+  size_t operator()(const block_key &key) const {
+    return std::hash<uint64_t>()(key.first * 0x9E3779B97F4A7C15ULL + key.second);
+  }
+};
+
+static std::mutex cache_mutex;
+static lru_cache<block_key, cached_block, block_key_hash> cache(0);
+
+// Ids of R vectors with cached blocks, by address. Only used on the main
+// thread.
+static std::unordered_map<SEXP, uint64_t> buffer_ids;
+static uint64_t last_id = 0;
+
+cached_block block_cache_get(uint64_t buffer, size_t block) {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cached_block *result = cache.get({buffer, block});
+  return result == nullptr ? cached_block() : *result;
+}
+
+void block_cache_put(uint64_t buffer, size_t block, cached_block data) {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  size_t bytes = data->size();
+  cache.put({buffer, block}, std::move(data), bytes);
+}
+
+// R keeps a garbage collected vector alive until its finalizer has run, so
+// its address cannot be reused before its blocks are forgotten
+static void forget_buffer(SEXP data) {
+  auto it = buffer_ids.find(data);
+  if (it == buffer_ids.end()) return;
+  uint64_t id = it->second;
+  buffer_ids.erase(it);
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cache.erase_if([id](const block_key &key) { return key.first == id; });
+}
+
+uint64_t block_cache_buffer_id(SEXP data) {
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (cache.max_bytes() == 0) return 0;
+  }
+  auto it = buffer_ids.find(data);
+  if (it != buffer_ids.end()) return it->second;
+  MARK_NOT_MUTABLE(data);
+  unwind_protect([&]() { R_MakeWeakRefC(data, R_NilValue, forget_buffer, FALSE); });
+  buffer_ids[data] = ++last_id;
+  return last_id;
+}
+
+[[cpp11::register]]
+list blosc_block_cache_(double max_bytes) {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  if (max_bytes >= 0) cache.set_max_bytes((size_t)max_bytes);
+  if (max_bytes == 0) cache.clear();
+  writable::list result({
+    as_sexp((double)cache.size()), as_sexp((double)cache.bytes()),
+    as_sexp((double)cache.max_bytes()), as_sexp((double)cache.hits()),
+    as_sexp((double)cache.misses()), as_sexp((double)cache.evictions())
+  });
+  result.attr("names") = writable::strings({
+    "entries", "bytes", "max_bytes", "hits", "misses", "evictions"
+  });
+  return result;
+}
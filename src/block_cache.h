@@ -0,0 +1,31 @@
+#ifndef BLOSC_BLOCK_CACHE_H
+#define BLOSC_BLOCK_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A process-wide cache of decompressed blocks, which speeds up repeated reads
+// from the same compressed buffers (see `blosc_blocks`). Blocks are keyed by
+// an id of the compressed buffer (obtained on the main thread with
+// `block_cache_buffer_id()`) and the index of the block. The cache is
+// disabled until it is given a byte budget. The functions below (except
+// `block_cache_buffer_id()`) are thread-safe and never call the R API.
+
+typedef std::shared_ptr<const std::vector<uint8_t>> cached_block;
+
+// Decompressed block `block` of buffer `buffer`, or an empty pointer
+cached_block block_cache_get(uint64_t buffer, size_t block);
+void block_cache_put(uint64_t buffer, size_t block, cached_block data);
+
+// Declared like in R's headers, which are not included by workers' code
+typedef struct SEXPREC *SEXP;
+
+// Id of R vector `data` to be used as `buffer` in the cache, or 0 when the
+// cache is disabled. The vector is marked as not mutable, such that R copies
+// it before modifying it, and its blocks are removed from the cache when it
+// is garbage collected.
+uint64_t block_cache_buffer_id(SEXP data);
+
+#endif /* BLOSC_BLOCK_CACHE_H */
@@ -0,0 +1,112 @@
+#ifndef BLOSC_BLOCKS_H
+#define BLOSC_BLOCKS_H
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "backend.h"
+#include "block_cache.h"
+
+// Provides access to the individual blocks of a blosc buffer, such that
+// only the blocks that are actually needed have to be decompressed. Blocks
+// are decompressed when they are first accessed and then kept in memory.
+// When the buffer has a `cache_id` (see `block_cache.h`), blocks are looked
+// up in and added to the process-wide block cache as well.
+// Errors are thrown as C++ exceptions, such that it can be used by workers.
+class blosc_blocks {
+public:
+  blosc_blocks(const uint8_t *src, size_t size, uint64_t cache_id = 0) :
+  src(src), src_size(size), cache_id(cache_id) {
+    size_t decomp_size = 0, cbytes = 0, flags_size = 0;
+    int flags = 0;
+    if (backend_cbuffer_validate(src, size, &decomp_size) < 0)
+      throw std::runtime_error("Invalid blosc data");
+    backend_cbuffer_sizes(src, &n_bytes, &cbytes, &block_size);
+    backend_cbuffer_metainfo(src, &flags_size, &flags);
+    type_size = flags_size;
+    // `backend_getitem()` can only address whole items, so buffers with
+    // trailing bytes are decompressed as a single block
+    if (block_size == 0 || type_size == 0 || block_size % type_size != 0 ||
+        n_bytes % type_size != 0 || block_size > n_bytes)
+      block_size = n_bytes;
+    n_blocks = block_size == 0 ? 0 : (n_bytes + block_size - 1) / block_size;
+    blocks.resize(n_blocks);
+  }
+
+  size_t nbytes() const {
+    return n_bytes;
+  }
+
+  size_t blocksize() const {
+    return block_size;
+  }
+
+  size_t nblocks() const {
+    return n_blocks;
+  }
+
+  size_t typesize() const {
+    return type_size;
+  }
+
+  // Size in bytes of decompressed block `b` (the last block may be smaller)
+  size_t block_bytes(size_t b) const {
+    size_t start = b * block_size;
+    return std::min(block_size, n_bytes - start);
+  }
+
+  // Decompress block `b` into `dest`, which should be `block_bytes(b)` long
+  void decompress_block(size_t b, uint8_t *dest) const {
+    if (b >= n_blocks) throw std::runtime_error("Block index out of range");
+    size_t nb = block_bytes(b);
+    int result;
+    if (n_blocks == 1 && nb == n_bytes) {
+      result = backend_decompress(src, src_size, dest, nb, 1);
+    } else {
+      result = backend_getitem(src, src_size, (int)(b * block_size / type_size),
+                               (int)(nb / type_size), dest, nb);
+    }
+    if (result < 0 || (size_t)result != nb)
+      throw std::runtime_error("Failed to decompress data");
+  }
+
+  // Decompressed block `b`
+  const uint8_t *block(size_t b) {
+    if (b >= n_blocks) throw std::runtime_error("Block index out of range");
+    if (!blocks[b] && cache_id != 0) blocks[b] = block_cache_get(cache_id, b);
+    if (!blocks[b]) {
+      auto data = std::make_shared<std::vector<uint8_t>>(block_bytes(b));
+      decompress_block(b, data->data());
+      if (cache_id != 0) block_cache_put(cache_id, b, data);
+      blocks[b] = data;
+    }
+    return blocks[b]->data();
+  }
+
+  // Copy `n` decompressed bytes starting at `offset` into `dest`
+  void copy(size_t offset, size_t n, uint8_t *dest) {
+    if (offset + n > n_bytes) throw std::runtime_error("Read beyond end of data");
+    while (n > 0) {
+      size_t b = offset / block_size, inner = offset % block_size;
+      size_t len = std::min(n, block_bytes(b) - inner);
+      memcpy(dest, block(b) + inner, len);
+      dest += len;
+      offset += len;
+      n -= len;
+    }
+  }
+
+private:
+  const uint8_t *src;
+  size_t src_size;
+  uint64_t cache_id;
+  size_t n_bytes = 0;
+  size_t block_size = 0;
+  size_t type_size = 0;
+  size_t n_blocks = 0;
+  std::vector<cached_block> blocks;
+};
+
+#endif /* BLOSC_BLOCKS_H */
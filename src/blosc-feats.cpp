@@ -1,22 +1,49 @@
 #include <cpp11.hpp>
-#include "blosc.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <R_ext/Rdynload.h>
+#include <R_ext/Visibility.h>
+#include "backend.h"
+#include "dict.h"
+#include "filters.h"
+#include "header.h"
 
 using namespace cpp11;
 
 [[cpp11::register]]
 list blosc_info_(raws data) {
   uint8_t *src = (uint8_t *)(RAW(as_sexp(data)));
+  std::vector<ext_section> sections;
+  size_t offset = ext_header_parse(src, data.size(), sections);
+  src += offset;
   size_t decomp_size = 0;
-  int version = -1, compversion = -1, flags = -1;
+  int version = NA_INTEGER, compversion = NA_INTEGER, flags = -1;
   size_t nbytes = 0, cbytes = 0, typesize = 0, bsize = 0;
   bool shuffle, memcop, bitshuf;
+  double dict_id = NA_REAL;
+  std::string cstr;
   
-  int validate = blosc_cbuffer_validate(src, data.size(), &decomp_size);
-  if (validate < 0) stop("Invalid blosc data");
-  std::string cstr = blosc_cbuffer_complib(src);
-  blosc_cbuffer_versions(src, &version, &compversion);
-  blosc_cbuffer_metainfo(src, &typesize, &flags);
-  blosc_cbuffer_sizes(src, &nbytes, &cbytes, &bsize);
+  const ext_section *dsec = ext_header_find(sections, EXT_DICT);
+  if (dsec != nullptr) {
+    // Data compressed with a dictionary is a zstd frame (see `dict.h`)
+    nbytes   = dict_nbytes(*dsec);
+    cbytes   = data.size() - offset;
+    typesize = dsec->payload[4];
+    bsize    = nbytes;
+    flags    = dsec->payload[5] != 0 ? 0x1 : 0;
+    dict_id  = (double)get_u32_le(dsec->payload.data());
+    cstr     = "Zstd";
+  } else {
+    int validate = backend_cbuffer_validate(src, data.size() - offset, &decomp_size);
+    if (validate < 0) stop("Invalid blosc data");
+    cstr = backend_cbuffer_complib(src);
+    backend_cbuffer_versions(src, &version, &compversion);
+    backend_cbuffer_metainfo(src, &typesize, &flags);
+    backend_cbuffer_sizes(src, &nbytes, &cbytes, &bsize);
+  }
   shuffle  = (flags & 0x1) != 0;
   memcop   = (flags & 0x2) != 0;
   bitshuf  = (flags & 0x4) != 0;
@@ -26,6 +53,19 @@ list blosc_info_(raws data) {
   sh[0] = shuffle;
   mc[0] = memcop;
   bs[0] = bitshuf;
+  std::vector<blosc_filter> filters = filters_from_header(sections);
+  writable::strings flt((R_xlen_t)filters.size());
+  for (size_t i = 0; i < filters.size(); i++)
+    flt[(R_xlen_t)i] = filter_name(filters[i]);
+  
+  writable::logicals st((R_xlen_t)1);
+  st[0] = ext_header_find(sections, EXT_STATS) != nullptr;
+  
+  // Number of levels of a compressed factor
+  const ext_section *lsec = ext_header_find(sections, EXT_LEVELS);
+  int nlevels = NA_INTEGER;
+  if (lsec != nullptr && lsec->payload.size() >= 8)
+    nlevels = (int)get_u32_le(lsec->payload.data() + 4);
   
   writable::list result({
     writable::strings({cstr}),
@@ -35,7 +75,10 @@ list blosc_info_(raws data) {
     writable::integers({(int)bsize}),
     writable::integers({(int)nbytes}),
     writable::integers({(int)cbytes}),
-    sh, mc, bs
+    sh, mc, bs, flt,
+    writable::doubles({dict_id}),
+    st,
+    writable::integers({nlevels})
   });
   result.attr("names") = writable::strings({
     "Compressor",
@@ -47,7 +90,11 @@ list blosc_info_(raws data) {
     "Compressed size in bytes",
     "Shuffle",
     "Pure memcpy",
-    "Bit shuffle"
+    "Bit shuffle",
+    "Filters",
+    "Dictionary ID",
+    "Block statistics",
+    "Factor levels"
   });
   result.attr("class") = writable::strings({
     "blosc_info",
@@ -55,3 +102,125 @@ list blosc_info_(raws data) {
   });
   return result;
 }
+
+[[cpp11::register]]
+list blosc_backend_() {
+  writable::list result({
+    writable::strings({backend_name()}),
+    writable::strings({backend_version()})
+  });
+  result.attr("names") = writable::strings({
+    "backend",
+    "version"
+  });
+  return result;
+}
+
+// SIMD instruction sets supported by the CPU. Blosc selects its shuffle
+// implementation at run time from the instruction sets that were enabled
+// when the library was built and that are supported by the CPU.
+static bool cpu_supports(const char *feature) {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  std::string f(feature);
+  if (f == "sse2") return __builtin_cpu_supports("sse2");
+  if (f == "avx2") return __builtin_cpu_supports("avx2");
+  if (f == "avx512f") return __builtin_cpu_supports("avx512f");
+  return false;
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+  return std::string(feature) == "neon";
+#else
+  return false;
+#endif
+}
+
+[[cpp11::register]]
+list blosc_capabilities_() {
+  writable::strings compressors;
+  std::stringstream ss(backend_list_compressors());
+  std::string item;
+  while (std::getline(ss, item, ',')) compressors.push_back(item);
+
+  const char *features[4] = {"sse2", "avx2", "avx512f", "neon"};
+  writable::logicals simd((R_xlen_t)4);
+  for (int i = 0; i < 4; i++) simd[i] = cpu_supports(features[i]);
+  simd.attr("names") = writable::strings({"sse2", "avx2", "avx512f", "neon"});
+
+  writable::list result({
+    writable::strings({backend_name()}),
+    writable::strings({backend_version()}),
+    compressors,
+    simd,
+    writable::logicals({dict_available()})
+  });
+  result.attr("names") = writable::strings({
+    "backend",
+    "version",
+    "compressors",
+    "cpu_simd",
+    "dictionary"
+  });
+  return result;
+}
+
+// Measures compression and decompression throughput (in MB/s) for each
+// shuffle mode, using `size` bytes of synthetic 32 bit integer data
+[[cpp11::register]]
+list blosc_self_test_(double size, std::string compressor, int nthreads) {
+  size_t n = (size_t)(size / sizeof(int32_t));
+  if (n < 1024) n = 1024;
+  // A noisy ramp: compressible, but only when shuffled well
+  std::vector<int32_t> data(n);
+  uint32_t state = 12345;
+  for (size_t i = 0; i < n; i++) {
+    state = state * 1103515245u + 12345u;
+    data[i] = (int32_t)(i * 3) + (int32_t)((state >> 16) & 0xFF);
+  }
+  size_t nbytes = n * sizeof(int32_t);
+  std::vector<uint8_t> compressed(nbytes + BACKEND_MAX_OVERHEAD);
+  std::vector<int32_t> restored(n);
+
+  const char *modes[3] = {"noshuffle", "shuffle", "bitshuffle"};
+  writable::strings shuffle;
+  writable::doubles comp_speed, decomp_speed, ratio;
+  for (int mode = 0; mode < 3; mode++) {
+    double best_c = 0, best_d = 0;
+    int csize = 0;
+    for (int rep = 0; rep < 3; rep++) {
+      auto t0 = std::chrono::steady_clock::now();
+      csize = backend_compress(5, mode, sizeof(int32_t), nbytes, data.data(),
+                               compressed.data(), compressed.size(),
+                               compressor.c_str(), 0, nthreads);
+      auto t1 = std::chrono::steady_clock::now();
+      if (csize <= 0) stop("Compression failed during self test");
+      int dsize = backend_decompress(compressed.data(), (size_t)csize, restored.data(),
+                                     nbytes, nthreads);
+      auto t2 = std::chrono::steady_clock::now();
+      if (dsize != (int)nbytes || memcmp(restored.data(), data.data(), nbytes) != 0)
+        stop("Decompressed data does not match the original during self test");
+      double tc = std::chrono::duration<double>(t1 - t0).count();
+      double td = std::chrono::duration<double>(t2 - t1).count();
+      if (tc > 0) best_c = std::max(best_c, nbytes / tc / 1e6);
+      if (td > 0) best_d = std::max(best_d, nbytes / td / 1e6);
+    }
+    shuffle.push_back(modes[mode]);
+    comp_speed.push_back(best_c);
+    decomp_speed.push_back(best_d);
+    ratio.push_back((double)nbytes / csize);
+  }
+  writable::list result({shuffle, comp_speed, decomp_speed, ratio});
+  result.attr("names") = writable::strings({
+    "shuffle",
+    "compress_mb_s",
+    "decompress_mb_s",
+    "ratio"
+  });
+  return result;
+}
+
+// Called by R when the package's shared library is unloaded. Worker threads
+// free their dictionary caches when they end; the main thread's cache is
+// freed here.
+extern "C" attribute_visible void R_unload_blosc(DllInfo *dll) {
+  dict_release();
+}
@@ -0,0 +1,137 @@
+#include <cpp11.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "backend.h"
+#include "lru.h"
+
+using namespace cpp11;
+
+// A value held by `blosc_cache()`: either the compressed memory of a vector
+// of type `rtype` (`LGLSXP`, `INTSXP`, `REALSXP` or `CPLXSXP`), or, when
+// `rtype` is `RAWSXP`, an R object serialized by `blosc_serialize()`
+typedef struct {
+  int rtype;
+  std::vector<uint8_t> data;
+} cache_value;
+
+typedef struct {
+  lru_cache<std::string, cache_value> entries;
+  std::string compressor;
+  int level;
+} compressed_cache;
+
+static size_t item_size(int rtype) {
+  switch (rtype) {
+  case LGLSXP:
+  case INTSXP:
+    return sizeof(int);
+  case REALSXP:
+    return sizeof(double);
+  case CPLXSXP:
+    return sizeof(Rcomplex);
+  default:
+    stop("Unsupported type of cached value");
+  }
+}
+
+static uint8_t *item_data(SEXP x) {
+  switch (TYPEOF(x)) {
+  case LGLSXP:
+    return (uint8_t *)LOGICAL(x);
+  case INTSXP:
+    return (uint8_t *)INTEGER(x);
+  case REALSXP:
+    return (uint8_t *)REAL(x);
+  default:
+    return (uint8_t *)COMPLEX(x);
+  }
+}
+
+[[cpp11::register]]
+SEXP blosc_cache_new_(double max_bytes, std::string compressor, int level) {
+  external_pointer<compressed_cache> cache(new compressed_cache{
+    lru_cache<std::string, cache_value>((size_t)max_bytes), compressor, level
+  });
+  return cache;
+}
+
+// Stores `value`, which is a serialized object when `serialized` is set.
+// Returns `false` when it does not fit in the cache.
+[[cpp11::register]]
+bool blosc_cache_set_(SEXP cache, std::string key, SEXP value, bool serialized) {
+  external_pointer<compressed_cache> c(cache);
+  cache_value entry;
+  if (serialized) {
+    entry.rtype = RAWSXP;
+    entry.data.assign(RAW(value), RAW(value) + Rf_xlength(value));
+  } else {
+    entry.rtype = TYPEOF(value);
+    size_t nbytes = (size_t)Rf_xlength(value) * item_size(entry.rtype);
+    // Complex numbers are shuffled as pairs of doubles
+    size_t typesize = entry.rtype == CPLXSXP ? sizeof(double) : item_size(entry.rtype);
+    entry.data.resize(nbytes + BACKEND_MAX_OVERHEAD);
+    int out = backend_compress(c->level, 1, typesize, nbytes, item_data(value),
+                               entry.data.data(), entry.data.size(),
+                               c->compressor.c_str(), 0, 1);
+    if (out < 0) stop("BLOSC compressor failed!");
+    entry.data.resize((size_t)out);
+    entry.data.shrink_to_fit();
+  }
+  size_t bytes = entry.data.size() + key.size();
+  return c->entries.put(key, std::move(entry), bytes);
+}
+
+// Returns `NULL` when `key` is absent. Vectors are decompressed directly
+// into the result. Serialized objects are returned as a `raw` vector wrapped
+// in a `list`, to be unserialized by the caller.
+[[cpp11::register]]
+SEXP blosc_cache_get_(SEXP cache, std::string key) {
+  external_pointer<compressed_cache> c(cache);
+  const cache_value *entry = c->entries.get(key);
+  if (entry == nullptr) return R_NilValue;
+  const uint8_t *src = entry->data.data();
+  size_t size = entry->data.size();
+  if (entry->rtype == RAWSXP) {
+    writable::raws data((R_xlen_t)size);
+    memcpy(RAW(as_sexp(data)), src, size);
+    writable::list result((R_xlen_t)1);
+    result[0] = data;
+    return result;
+  }
+  size_t nbytes = 0;
+  if (backend_cbuffer_validate(src, size, &nbytes) < 0)
+    stop("Corrupt value in cache");
+  sexp result = safe[Rf_allocVector](entry->rtype,
+                                     (R_xlen_t)(nbytes / item_size(entry->rtype)));
+  if (backend_decompress(src, size, item_data(result), nbytes, 1) < 0)
+    stop("Failed to decompress data");
+  return result;
+}
+
+[[cpp11::register]]
+bool blosc_cache_remove_(SEXP cache, std::string key) {
+  external_pointer<compressed_cache> c(cache);
+  return c->entries.erase(key);
+}
+
+[[cpp11::register]]
+void blosc_cache_clear_(SEXP cache) {
+  external_pointer<compressed_cache> c(cache);
+  c->entries.clear();
+}
+
+[[cpp11::register]]
+list blosc_cache_stats_(SEXP cache) {
+  external_pointer<compressed_cache> c(cache);
+  const lru_cache<std::string, cache_value> &e = c->entries;
+  writable::list result({
+    as_sexp((double)e.size()), as_sexp((double)e.bytes()),
+    as_sexp((double)e.max_bytes()), as_sexp((double)e.hits()),
+    as_sexp((double)e.misses()), as_sexp((double)e.evictions())
+  });
+  result.attr("names") = writable::strings({
+    "entries", "bytes", "max_bytes", "hits", "misses", "evictions"
+  });
+  return result;
+}
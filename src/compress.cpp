@@ -1,37 +1,538 @@
 #include <cpp11.hpp>
-#include "blosc.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include "backend.h"
+#include "dict.h"
+#include "dtype.h"
+#include "filters.h"
+#include "header.h"
+#include "scan.h"
 
 using namespace cpp11;
 
 raws blosc_compress_internal(uint8_t *p, R_xlen_t s, std::string compressor,
                              int level, int doshuffle, int typesize) {
-  writable::raws result(s + BLOSC_MAX_OVERHEAD);
+  writable::raws result(s + BACKEND_MAX_OVERHEAD);
   uint8_t *dest = (uint8_t *)(RAW(as_sexp(result)));
-  int out = blosc_compress_ctx(level, doshuffle, typesize, s, p, dest, result.size(),
-                               compressor.c_str(), 0, 1);
+  int out = backend_compress(level, doshuffle, typesize, s, p, dest, result.size(),
+                             compressor.c_str(), 0, 1);
   if (out < 0) stop("BLOSC compressor failed!");
   result.resize(out);
   return result;
 }
 
+// Compresses `p` preceded by an extension header with `sections`
+raws blosc_compress_ext(uint8_t *p, R_xlen_t s, std::string compressor,
+                        int level, int doshuffle, int typesize,
+                        const std::vector<ext_section> &sections) {
+  if (sections.empty())
+    return blosc_compress_internal(p, s, compressor, level, doshuffle, typesize);
+  std::vector<uint8_t> header = ext_header_encode(sections);
+  R_xlen_t hs = (R_xlen_t)header.size();
+  writable::raws result(hs + s + BACKEND_MAX_OVERHEAD);
+  uint8_t *dest = (uint8_t *)(RAW(as_sexp(result)));
+  memcpy(dest, header.data(), header.size());
+  int out = backend_compress(level, doshuffle, typesize, s, p, dest + hs,
+                             result.size() - hs, compressor.c_str(), 0, 1);
+  if (out < 0) stop("BLOSC compressor failed!");
+  result.resize(hs + out);
+  return result;
+}
+
+// Memory of a raw vector, or of an integer, double or complex vector that
+// is compressed as is (see `dtype_is_native_()`)
+static uint8_t *vector_bytes(SEXP data, size_t &nbytes) {
+  R_xlen_t n = Rf_xlength(data);
+  switch (TYPEOF(data)) {
+  case RAWSXP:
+    nbytes = (size_t)n;
+    return (uint8_t *)RAW(data);
+  case INTSXP:
+    nbytes = (size_t)n * sizeof(int);
+    return (uint8_t *)INTEGER(data);
+  case REALSXP:
+    nbytes = (size_t)n * sizeof(double);
+    return (uint8_t *)REAL(data);
+  case CPLXSXP:
+    nbytes = (size_t)n * sizeof(Rcomplex);
+    return (uint8_t *)COMPLEX(data);
+  default:
+    stop("Data to compress should be a raw, integer, double or complex vector");
+  }
+}
+
+static std::vector<blosc_filter> create_filters(strings filters, doubles params,
+                                                int typesize, bool big_endian,
+                                                bool is_signed) {
+  if (params.size() != filters.size())
+    stop("Each filter should have a parameter");
+  std::vector<blosc_filter> result;
+  for (R_xlen_t i = 0; i < filters.size(); i++)
+    result.push_back(filter_create(std::string(filters[i]), typesize, big_endian,
+                                   is_signed, params[i]));
+  return result;
+}
+
+// Compresses `p` with a zstd dictionary (see `dict.h`)
+static raws blosc_compress_dict(uint8_t *p, R_xlen_t s, int level, int doshuffle,
+                                int typesize, raws dict,
+                                std::vector<ext_section> sections) {
+  std::vector<uint8_t> frame;
+  sections.push_back(dict_compress(p, (size_t)s, level, typesize, doshuffle == 1,
+                                   (const uint8_t *)RAW(as_sexp(dict)),
+                                   (size_t)dict.size(), frame));
+  std::vector<uint8_t> header = ext_header_encode(sections);
+  writable::raws result((R_xlen_t)(header.size() + frame.size()));
+  uint8_t *dest = (uint8_t *)(RAW(as_sexp(result)));
+  memcpy(dest, header.data(), header.size());
+  memcpy(dest + header.size(), frame.data(), frame.size());
+  return result;
+}
+
+// Compresses `p` preceded by an `EXT_STATS` section with the statistics of
+// each blosc block (see `scan.h`). The block size is chosen by blosc, so the
+// statistics are computed after compression.
+static raws blosc_compress_stats(uint8_t *p, R_xlen_t s, std::string compressor,
+                                 int level, int doshuffle, int typesize,
+                                 const blosc_dtype &dt) {
+  std::vector<uint8_t> data((size_t)s + BACKEND_MAX_OVERHEAD);
+  int out = backend_compress(level, doshuffle, typesize, (size_t)s, p, data.data(),
+                             data.size(), compressor.c_str(), 0, 1);
+  if (out < 0) stop("BLOSC compressor failed!");
+  size_t nbytes = 0, cbytes = 0, blocksize = 0, item = dt.byte_size;
+  backend_cbuffer_sizes(data.data(), &nbytes, &cbytes, &blocksize);
+  if (nbytes % item != 0)
+    stop("Raw data size needs to be multitude of data type size");
+  // Blocks that split elements cannot be scanned separately, so a single
+  // entry then covers all data
+  size_t block_items = blocksize > 0 && blocksize % item == 0 ?
+    blocksize / item : std::max(nbytes / item, (size_t)1);
+  std::vector<uint8_t> header = ext_header_encode({stats_section(p, nbytes, dt, block_items)});
+  writable::raws result((R_xlen_t)header.size() + out);
+  uint8_t *dest = (uint8_t *)(RAW(as_sexp(result)));
+  memcpy(dest, header.data(), header.size());
+  memcpy(dest + header.size(), data.data(), (size_t)out);
+  return result;
+}
+
 [[cpp11::register]]
-raws blosc_compress_dat(raws data, std::string compressor, int level, int doshuffle,
-                    int typesize) {
-  uint8_t *src = (uint8_t *)(RAW(as_sexp(data)));
-  return blosc_compress_internal(src, (R_xlen_t)data.size(), compressor,
-                                 level, doshuffle, typesize);
+raws blosc_compress_dat(SEXP data, std::string compressor, int level, int doshuffle,
+                        int typesize, strings filters, doubles params,
+                        bool big_endian, bool is_signed, raws dict,
+                        std::string stats) {
+  size_t size = 0;
+  uint8_t *src = vector_bytes(data, size);
+  if (!stats.empty()) {
+    // Statistics describe the data as stored, so it cannot be transformed
+    if (filters.size() > 0 || dict.size() > 0)
+      stop("Block statistics cannot be combined with filters or a dictionary");
+    return blosc_compress_stats(src, (R_xlen_t)size, compressor, level, doshuffle,
+                                typesize, prepare_dtype(stats));
+  }
+  std::vector<ext_section> sections;
+  std::vector<uint8_t> filtered;
+  if (filters.size() > 0) {
+    std::vector<blosc_filter> flt =
+      create_filters(filters, params, typesize, big_endian, is_signed);
+    // Filters are applied to a copy, leaving the input untouched
+    filtered.assign(src, src + size);
+    filters_forward(flt, filtered.data(), filtered.size());
+    src = filtered.data();
+    sections.push_back(filters_section(flt));
+  }
+  if (dict.size() > 0)
+    return blosc_compress_dict(src, (R_xlen_t)size, level, doshuffle,
+                               typesize, dict, sections);
+  return blosc_compress_ext(src, (R_xlen_t)size, compressor, level,
+                            doshuffle, typesize, sections);
 }
 
+// Factors are compressed as their integer codes, in the narrowest of "|u1",
+// "<u2" and "<i4" that holds the number of levels. Missing values are code 0,
+// except in "<i4", which keeps R's codes as is. The levels are stored in an
+// extension header section: the code size in bytes (1 byte), whether the
+// factor is ordered (1 byte), 2 reserved bytes and the number of levels
+// (uint32 LE), followed by the length (uint32 LE) and UTF-8 bytes of each
+// level.
+static ext_section levels_section(strings levels, int code_size, bool ordered) {
+  ext_section result = {EXT_LEVELS, std::vector<uint8_t>(8, 0)};
+  result.payload[0] = (uint8_t)code_size;
+  result.payload[1] = ordered ? 1 : 0;
+  put_u32_le(result.payload.data() + 4, (uint32_t)levels.size());
+  for (R_xlen_t i = 0; i < levels.size(); i++) {
+    const char *level = Rf_translateCharUTF8(STRING_ELT(as_sexp(levels), i));
+    uint32_t len = (uint32_t)strlen(level);
+    size_t pos = result.payload.size();
+    result.payload.resize(pos + 4 + len);
+    put_u32_le(result.payload.data() + pos, len);
+    memcpy(result.payload.data() + pos + 4, level, len);
+  }
+  return result;
+}
+
+[[cpp11::register]]
+raws blosc_compress_factor_(integers codes, strings levels, bool ordered,
+                            std::string compressor, int level, int doshuffle) {
+  R_xlen_t nlevels = levels.size();
+  int code_size = nlevels <= 0xff ? 1 : nlevels <= 0xffff ? 2 : 4;
+  std::vector<ext_section> sections = {levels_section(levels, code_size, ordered)};
+  R_xlen_t n = codes.size();
+  const int *src = INTEGER(as_sexp(codes));
+#ifndef WORDS_BIGENDIAN
+  if (code_size == 4)
+    return blosc_compress_ext((uint8_t *)src, n * 4, compressor, level, doshuffle,
+                              4, sections);
+#endif
+  std::vector<uint8_t> narrow((size_t)n * code_size);
+  for (R_xlen_t i = 0; i < n; i++) {
+    int code = src[i];
+    if (code != NA_INTEGER && (code < 1 || code > nlevels))
+      stop("Factor codes are out of the range of its levels");
+    uint8_t *p = narrow.data() + i * code_size;
+    if (code_size == 4) {
+      put_u32_le(p, (uint32_t)code);
+    } else {
+      uint32_t v = code == NA_INTEGER ? 0 : (uint32_t)code;
+      p[0] = (uint8_t)v;
+      if (code_size == 2) p[1] = (uint8_t)(v >> 8);
+    }
+  }
+  return blosc_compress_ext(narrow.data(), (R_xlen_t)narrow.size(), compressor,
+                            level, doshuffle, code_size, sections);
+}
+
+[[cpp11::register]]
+raws blosc_train_dict_(list samples, int dict_size) {
+  std::vector<uint8_t> buffer;
+  std::vector<size_t> sizes;
+  for (R_xlen_t i = 0; i < samples.size(); i++) {
+    raws sample(samples[i]);
+    const uint8_t *p = (const uint8_t *)RAW(as_sexp(sample));
+    buffer.insert(buffer.end(), p, p + sample.size());
+    sizes.push_back((size_t)sample.size());
+  }
+  std::vector<uint8_t> dict = dict_train(buffer, sizes, (size_t)dict_size);
+  writable::raws result((R_xlen_t)dict.size());
+  memcpy(RAW(as_sexp(result)), dict.data(), dict.size());
+  return result;
+}
+
+// Applies filters without compressing, used to assess the effect of
+// lossy filters
 [[cpp11::register]]
-raws blosc_decompress_dat(raws data) {
-  uint8_t *src = (uint8_t *)(RAW(as_sexp(data)));
-  size_t decomp_size = 0;
-  int validate = blosc_cbuffer_validate(src, data.size(), &decomp_size);
-  if (validate < 0) stop("Unable to decompress data");
-  writable::raws result((R_xlen_t)decomp_size);
+raws blosc_filter_dat(raws data, strings filters, doubles params, int typesize,
+                      bool big_endian, bool is_signed) {
+  std::vector<blosc_filter> flt =
+    create_filters(filters, params, typesize, big_endian, is_signed);
+  writable::raws result((R_xlen_t)data.size());
   uint8_t *dest = (uint8_t *)(RAW(as_sexp(result)));
-  
-  int test = blosc_decompress_ctx(src, dest, decomp_size, 1);
-  if (test < 0) stop("Failed to decompress data");
+  memcpy(dest, RAW(as_sexp(data)), data.size());
+  filters_forward(flt, dest, data.size());
+  return result;
+}
+
+// Parses the extension header of `src`, and returns the size of the data
+// when it is decompressed
+static size_t decompressed_nbytes(const uint8_t *src, size_t size, size_t &offset,
+                                  std::vector<ext_section> &sections) {
+  offset = ext_header_parse(src, size, sections);
+  const ext_section *dsec = ext_header_find(sections, EXT_DICT);
+  if (dsec != nullptr) return dict_nbytes(*dsec);
+  size_t nbytes = 0;
+  if (backend_cbuffer_validate(src + offset, size - offset, &nbytes) < 0)
+    throw std::runtime_error("Unable to decompress data");
+  return nbytes;
+}
+
+// Decompresses `src` into `nbytes` at `dest` without using the R API, such
+// that it can run on a background thread
+static void decompress_into(const uint8_t *src, size_t size, size_t offset,
+                            const std::vector<ext_section> &sections,
+                            const uint8_t *dict, size_t dict_size,
+                            uint8_t *dest, size_t nbytes) {
+  const ext_section *dsec = ext_header_find(sections, EXT_DICT);
+  if (dsec != nullptr) {
+    dict_decompress(*dsec, src + offset, size - offset, dict, dict_size, dest);
+  } else if (backend_decompress(src + offset, size - offset, dest, nbytes, 1) < 0) {
+    throw std::runtime_error("Failed to decompress data");
+  }
+  filters_inverse(filters_from_header(sections), dest, nbytes);
+}
+
+// Rebuilds a factor from the codes of `nbytes` at `src` and the levels
+// section `sec` (see `levels_section()`), with a single CHARSXP per level
+static SEXP decode_factor(const ext_section &sec, const uint8_t *src, size_t nbytes) {
+  const std::vector<uint8_t> &payload = sec.payload;
+  if (payload.size() < 8) stop("Corrupt factor levels");
+  size_t code_size = payload[0];
+  uint32_t nlevels = get_u32_le(payload.data() + 4);
+  if ((code_size != 1 && code_size != 2 && code_size != 4) || nbytes % code_size != 0)
+    stop("Corrupt factor levels");
+  writable::strings levels((R_xlen_t)nlevels);
+  size_t pos = 8;
+  for (uint32_t i = 0; i < nlevels; i++) {
+    if (payload.size() - pos < 4) stop("Corrupt factor levels");
+    uint32_t len = get_u32_le(payload.data() + pos);
+    pos += 4;
+    if (payload.size() - pos < len) stop("Corrupt factor levels");
+    SET_STRING_ELT(levels, (R_xlen_t)i,
+                   Rf_mkCharLenCE((const char *)payload.data() + pos, (int)len, CE_UTF8));
+    pos += len;
+  }
+
+  R_xlen_t n = (R_xlen_t)(nbytes / code_size);
+  writable::integers result(n);
+  int *dest = INTEGER(as_sexp(result));
+  for (R_xlen_t i = 0; i < n; i++) {
+    const uint8_t *p = src + i * code_size;
+    int code;
+    if (code_size == 4) {
+      code = (int)get_u32_le(p);
+    } else {
+      code = code_size == 2 ? (int)(p[0] | (p[1] << 8)) : (int)p[0];
+      if (code == 0) code = NA_INTEGER;
+    }
+    if (code != NA_INTEGER && (code < 1 || (uint32_t)code > nlevels))
+      stop("Corrupt factor codes");
+    dest[i] = code;
+  }
+  result.attr("levels") = levels;
+  if (payload[1] != 0)
+    result.attr("class") = writable::strings({"ordered", "factor"});
+  else
+    result.attr("class") = "factor";
+  return result;
+}
+
+// Returns a `raw` vector, or a factor when `data` holds compressed factor
+// codes (see `blosc_compress_factor_()`)
+[[cpp11::register]]
+SEXP blosc_decompress_dat(raws data, raws dict) {
+  const uint8_t *src = (const uint8_t *)(RAW(as_sexp(data)));
+  std::vector<ext_section> sections;
+  size_t offset = 0;
+  size_t nbytes = decompressed_nbytes(src, data.size(), offset, sections);
+  writable::raws result((R_xlen_t)nbytes);
+  decompress_into(src, data.size(), offset, sections,
+                  (const uint8_t *)RAW(as_sexp(dict)), (size_t)dict.size(),
+                  (uint8_t *)RAW(as_sexp(result)), nbytes);
+  const ext_section *lsec = ext_header_find(sections, EXT_LEVELS);
+  if (lsec != nullptr)
+    return decode_factor(*lsec, (const uint8_t *)RAW(as_sexp(result)), nbytes);
+  return result;
+}
+
+// Decompresses directly into an R vector when `dtype` is stored by R as is
+// (see `dtype_native_rtype()`), such that no conversion is needed. Returns
+// `NULL` for other data types.
+[[cpp11::register]]
+SEXP blosc_decompress_native_(raws data, raws dict, std::string dtype, sexp na_value) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  int rtype = dtype_native_rtype(dt);
+  if (rtype == NILSXP) return R_NilValue;
+  const uint8_t *src = (const uint8_t *)(RAW(as_sexp(data)));
+  std::vector<ext_section> sections;
+  size_t offset = 0;
+  size_t nbytes = decompressed_nbytes(src, data.size(), offset, sections);
+  // Factors are rebuilt from their levels by `blosc_decompress_dat()`
+  if (ext_header_find(sections, EXT_LEVELS) != nullptr) return R_NilValue;
+  if (nbytes % dt.byte_size != 0)
+    stop("Raw data size needs to be multitude of data type size");
+  blosc_na na = resolve_na(na_value, rtype);
+  sexp result = safe[Rf_allocVector](rtype, (R_xlen_t)(nbytes / dt.byte_size));
+  uint8_t *dest = rtype == INTSXP ? (uint8_t *)INTEGER(result) :
+    rtype == REALSXP ? (uint8_t *)REAL(result) : (uint8_t *)COMPLEX(result);
+  decompress_into(src, data.size(), offset, sections,
+                  (const uint8_t *)RAW(as_sexp(dict)), (size_t)dict.size(),
+                  dest, nbytes);
+  if (native_na_inverse(result, na))
+    warning("Data contains values equal to R's NA representation");
+  return result;
+}
+
+// Decompresses 64 bit integers directly into an `integer64` vector, of
+// which the byte order and missing values are fixed up in place
+[[cpp11::register]]
+SEXP blosc_decompress_integer64_(raws data, raws dict, std::string dtype,
+                                 sexp na_value) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  check_integer64(dt);
+  const uint8_t *src = (const uint8_t *)(RAW(as_sexp(data)));
+  std::vector<ext_section> sections;
+  size_t offset = 0;
+  size_t nbytes = decompressed_nbytes(src, data.size(), offset, sections);
+  // Factors are rebuilt from their levels, whatever the `dtype`
+  if (ext_header_find(sections, EXT_LEVELS) != nullptr)
+    return blosc_decompress_dat(data, dict);
+  if (nbytes % 8 != 0)
+    stop("Raw data size needs to be multitude of data type size");
+  integer64_na na = resolve_integer64_na(na_value);
+  sexp result = safe[Rf_allocVector](REALSXP, (R_xlen_t)(nbytes / 8));
+  uint8_t *dest = (uint8_t *)REAL(result);
+  decompress_into(src, data.size(), offset, sections,
+                  (const uint8_t *)RAW(as_sexp(dict)), (size_t)dict.size(),
+                  dest, nbytes);
+  integer64_decode(dest, nbytes / 8, dt, na);
+  set_integer64_class(result);
+  return result;
+}
+
+// Compresses like `blosc_compress_dat()` without using the R API, such that
+// it can run on a background thread. Errors are thrown as C++ exceptions.
+static std::vector<uint8_t> compress_buffer(const uint8_t *src, size_t size,
+                                            const std::string &compressor,
+                                            int level, int doshuffle, int typesize,
+                                            std::vector<blosc_filter> flt,
+                                            const uint8_t *dict, size_t dict_size) {
+  std::vector<ext_section> sections;
+  std::vector<uint8_t> filtered;
+  if (!flt.empty()) {
+    filtered.assign(src, src + size);
+    filters_forward(flt, filtered.data(), size);
+    src = filtered.data();
+    sections.push_back(filters_section(flt));
+  }
+  std::vector<uint8_t> data;
+  if (dict_size > 0) {
+    sections.push_back(dict_compress(src, size, level, typesize, doshuffle == 1,
+                                     dict, dict_size, data));
+  } else {
+    data.resize(size + BACKEND_MAX_OVERHEAD);
+    int out = backend_compress(level, doshuffle, typesize, size, src, data.data(),
+                               data.size(), compressor.c_str(), 0, 1);
+    if (out < 0) throw std::runtime_error("BLOSC compressor failed!");
+    data.resize((size_t)out);
+  }
+  if (sections.empty()) return data;
+  std::vector<uint8_t> result = ext_header_encode(sections);
+  result.insert(result.end(), data.begin(), data.end());
+  return result;
+}
+
+// A compression or decompression job running on a background thread.
+// Workers read the input directly from R's memory, and decompress directly
+// into the resulting R vector. These vectors are kept alive by the handle
+// (see `async_handle()`), and R duplicates vectors referenced by the handle
+// before modifying them, so workers never see them change.
+class async_job {
+public:
+  std::vector<uint8_t> compressed; // result of a compression job
+  std::string error;
+  bool collected = false;
+  // Declared last, such that it is destroyed first: destroying it waits for
+  // the worker to finish
+  std::future<void> done;
+
+  // Waits for the worker, while allowing the user to interrupt R
+  void wait() {
+    if (collected) return;
+    while (done.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready)
+      check_user_interrupt();
+    collected = true;
+    try {
+      done.get();
+    } catch (const std::exception &e) {
+      error = e.what();
+      if (error.empty()) error = "Asynchronous job failed";
+    }
+  }
+};
+
+static void async_finalize(SEXP handle) {
+  delete (async_job *)R_ExternalPtrAddr(handle);
+  R_ClearExternalPtr(handle);
+}
+
+// Creates a handle for a job that is started afterwards. The handle protects
+// the input, the dictionary and (for decompression) the output vector.
+static SEXP async_handle(SEXP input, SEXP dict, SEXP output) {
+  SEXP prot = PROTECT(Rf_allocVector(VECSXP, 3));
+  SET_VECTOR_ELT(prot, 0, input);
+  SET_VECTOR_ELT(prot, 1, dict);
+  SET_VECTOR_ELT(prot, 2, output);
+  SEXP handle = PROTECT(R_MakeExternalPtr(nullptr, R_NilValue, prot));
+  R_RegisterCFinalizerEx(handle, async_finalize, TRUE);
+  UNPROTECT(2);
+  return handle;
+}
+
+static void async_start(SEXP handle, std::function<void(async_job *)> task) {
+  std::unique_ptr<async_job> job(new async_job());
+  async_job *p = job.get();
+  job->done = std::async(std::launch::async, [task, p]() { task(p); });
+  R_SetExternalPtrAddr(handle, job.release());
+}
+
+static async_job *async_get(SEXP handle) {
+  async_job *job = (async_job *)R_ExternalPtrAddr(handle);
+  if (job == nullptr) stop("The result of the asynchronous job was already retrieved");
+  return job;
+}
+
+[[cpp11::register]]
+SEXP blosc_compress_async_(SEXP data, std::string compressor, int level,
+                           int doshuffle, int typesize, strings filters,
+                           doubles params, bool big_endian, bool is_signed,
+                           SEXP dict) {
+  std::vector<blosc_filter> flt =
+    create_filters(filters, params, typesize, big_endian, is_signed);
+  sexp handle = unwind_protect([&]() { return async_handle(data, dict, R_NilValue); });
+  size_t size = 0;
+  const uint8_t *src = vector_bytes(data, size);
+  const uint8_t *dict_src = (const uint8_t *)RAW(dict);
+  size_t dict_size = (size_t)Rf_xlength(dict);
+  async_start(handle, [=](async_job *job) {
+    job->compressed = compress_buffer(src, size, compressor, level, doshuffle,
+                                      typesize, flt, dict_src, dict_size);
+  });
+  return handle;
+}
+
+[[cpp11::register]]
+SEXP blosc_decompress_async_(SEXP data, SEXP dict) {
+  const uint8_t *src = (const uint8_t *)RAW(data);
+  size_t size = (size_t)Rf_xlength(data);
+  std::vector<ext_section> sections;
+  size_t offset = 0;
+  size_t nbytes = decompressed_nbytes(src, size, offset, sections);
+  if (ext_header_find(sections, EXT_LEVELS) != nullptr)
+    stop("Compressed factors can only be decompressed with `blosc_decompress()`");
+  writable::raws output((R_xlen_t)nbytes);
+  sexp handle = unwind_protect([&]() { return async_handle(data, dict, output); });
+  uint8_t *dest = (uint8_t *)RAW(as_sexp(output));
+  const uint8_t *dict_src = (const uint8_t *)RAW(dict);
+  size_t dict_size = (size_t)Rf_xlength(dict);
+  async_start(handle, [=](async_job *) {
+    decompress_into(src, size, offset, sections, dict_src, dict_size, dest, nbytes);
+  });
+  return handle;
+}
+
+[[cpp11::register]]
+bool blosc_async_resolved_(SEXP handle) {
+  async_job *job = (async_job *)R_ExternalPtrAddr(handle);
+  return job == nullptr || job->collected ||
+    job->done.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+[[cpp11::register]]
+SEXP blosc_async_value_(SEXP handle) {
+  async_job *job = async_get(handle);
+  job->wait();
+  if (!job->error.empty()) stop("%s", job->error.c_str());
+  sexp result = VECTOR_ELT(R_ExternalPtrProtected(handle), 2);
+  if (result == R_NilValue) {
+    writable::raws compressed((R_xlen_t)job->compressed.size());
+    if (!job->compressed.empty())
+      memcpy(RAW(as_sexp(compressed)), job->compressed.data(), job->compressed.size());
+    result = compressed;
+  }
+  // The job is finished, so its memory and the input can be released
+  async_finalize(handle);
+  R_SetExternalPtrProtected(handle, R_NilValue);
   return result;
 }
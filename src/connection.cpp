@@ -0,0 +1,158 @@
+#include <cpp11.hpp>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include "container.h"
+
+// The members `class` and `private` of R's connection struct are reserved
+// words in C++
+#define class class_name
+#define private private_ptr
+#include <R_ext/Connections.h>
+#undef class
+#undef private
+
+#if R_CONNECTIONS_VERSION != 1
+#error "Unsupported version of R's connection API"
+#endif
+
+using namespace cpp11;
+
+// A connection that reads or writes a blosc container (see `container.h`).
+// Data is buffered into chunks, which are (de)compressed by background
+// workers. R calls the functions below from its C code, so C++ exceptions
+// are caught and raised as R errors once no C++ objects are left to unwind.
+typedef struct {
+  std::string path;
+  std::string compressor;
+  int level;
+  int doshuffle;
+  int typesize;
+  size_t chunk_size;
+  int nthreads;
+  std::unique_ptr<container_file> file;
+  std::unique_ptr<container_writer> writer;
+  std::unique_ptr<container_reader> reader;
+  std::string error;
+} blosc_conn;
+
+static blosc_conn *get_state(Rconnection con) {
+  return (blosc_conn *)con->private_ptr;
+}
+
+static void reset_state(blosc_conn *state) {
+  state->reader.reset();
+  state->writer.reset();
+  state->file.reset();
+}
+
+static Rboolean blosc_conn_open(Rconnection con) {
+  blosc_conn *state = get_state(con);
+  bool write = con->mode[0] == 'w' || con->mode[0] == 'a';
+  try {
+    if (con->mode[0] == 'a' || strchr(con->mode, '+') != nullptr)
+      throw std::runtime_error("Blosc connections can only be opened for reading or writing");
+    state->file.reset(new container_file(state->path, write));
+    if (write) {
+      state->writer.reset(new container_writer(state->file->sink(), state->compressor,
+                                               state->level, state->doshuffle,
+                                               state->typesize, state->chunk_size,
+                                               state->nthreads));
+    } else {
+      state->reader.reset(new container_reader(state->file->source(), state->nthreads));
+    }
+  } catch (const std::exception &e) {
+    reset_state(state);
+    state->error = e.what();
+  }
+  if (!state->file) {
+    Rf_warning("%s", state->error.c_str());
+    return FALSE;
+  }
+  con->isopen = TRUE;
+  con->canwrite = write ? TRUE : FALSE;
+  con->canread = write ? FALSE : TRUE;
+  con->text = strchr(con->mode, 'b') != nullptr ? FALSE : TRUE;
+  con->save = -1000;
+  return TRUE;
+}
+
+static void blosc_conn_close(Rconnection con) {
+  blosc_conn *state = get_state(con);
+  bool failed = false;
+  try {
+    if (state->writer) state->writer->finish();
+    if (state->file) state->file->close();
+  } catch (const std::exception &e) {
+    state->error = e.what();
+    failed = true;
+  }
+  reset_state(state);
+  con->isopen = FALSE;
+  if (failed) Rf_error("%s", state->error.c_str());
+}
+
+static void blosc_conn_destroy(Rconnection con) {
+  delete get_state(con);
+  con->private_ptr = nullptr;
+}
+
+static size_t blosc_conn_write(const void *ptr, size_t size, size_t nitems,
+                               Rconnection con) {
+  blosc_conn *state = get_state(con);
+  try {
+    state->writer->write((const uint8_t *)ptr, size * nitems);
+    return nitems;
+  } catch (const std::exception &e) {
+    state->error = e.what();
+  }
+  Rf_error("%s", state->error.c_str());
+  return 0;
+}
+
+static size_t blosc_conn_read(void *ptr, size_t size, size_t nitems, Rconnection con) {
+  blosc_conn *state = get_state(con);
+  try {
+    return state->reader->read((uint8_t *)ptr, size * nitems) / size;
+  } catch (const std::exception &e) {
+    state->error = e.what();
+  }
+  Rf_error("%s", state->error.c_str());
+  return 0;
+}
+
+static int blosc_conn_fgetc(Rconnection con) {
+  uint8_t c;
+  // -1 signals the end of the data
+  return blosc_conn_read(&c, 1, 1, con) == 1 ? (int)c : -1;
+}
+
+[[cpp11::register]]
+SEXP blosc_connection_(std::string path, std::string mode, std::string compressor,
+                       int level, int doshuffle, int typesize, double chunk_size,
+                       int nthreads) {
+  Rconnection con;
+  SEXP result = PROTECT(unwind_protect([&]() {
+    return R_new_custom_connection(path.c_str(), mode.c_str(), "blosc", &con);
+  }));
+  blosc_conn *state = new blosc_conn();
+  state->path = path;
+  state->compressor = compressor;
+  state->level = level;
+  state->doshuffle = doshuffle;
+  state->typesize = typesize;
+  state->chunk_size = (size_t)chunk_size;
+  state->nthreads = nthreads;
+  con->private_ptr = state;
+  con->open = &blosc_conn_open;
+  con->close = &blosc_conn_close;
+  con->destroy = &blosc_conn_destroy;
+  con->read = &blosc_conn_read;
+  con->write = &blosc_conn_write;
+  con->fgetc_internal = &blosc_conn_fgetc;
+  con->canseek = FALSE;
+  con->blocking = TRUE;
+  con->isopen = FALSE;
+  UNPROTECT(1);
+  return result;
+}
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include "backend.h"
+#include "container.h"
+#include "header.h"
+
+std::vector<uint8_t> container_compress_chunk(const uint8_t *p, size_t n,
+                                              const std::string &compressor,
+                                              int level, int doshuffle, int typesize) {
+  std::vector<uint8_t> result(n + BACKEND_MAX_OVERHEAD);
+  int out = backend_compress(level, doshuffle, (size_t)typesize, n, p, result.data(),
+                             result.size(), compressor.c_str(), 0, 1);
+  if (out <= 0) throw std::runtime_error("BLOSC compressor failed!");
+  result.resize((size_t)out);
+  return result;
+}
+
+std::vector<uint8_t> container_decompress_chunk(const uint8_t *p, size_t n,
+                                                size_t max_nbytes) {
+  size_t nbytes = 0;
+  if (backend_cbuffer_validate(p, n, &nbytes) < 0 || nbytes > max_nbytes)
+    throw std::runtime_error("Corrupt chunk in container");
+  std::vector<uint8_t> result(nbytes);
+  int out = backend_decompress(p, n, result.data(), nbytes, 1);
+  if (out < 0 || (size_t)out != nbytes)
+    throw std::runtime_error("Failed to decompress data");
+  return result;
+}
+
+container_footer container_parse_footer(const uint8_t *p) {
+  if (memcmp(p + 24, "BLXE", 4) != 0)
+    throw std::runtime_error("Blosc container is incomplete or corrupt");
+  return {get_u64_le(p), get_u64_le(p + 8), get_u64_le(p + 16)};
+}
+
+container_index container_parse_index(const uint8_t *p, size_t size) {
+  if (size < BLXC_HEADER_SIZE + BLXC_INDEX_SIZE + BLXC_FOOTER_SIZE ||
+      memcmp(p, "BLXC", 4) != 0)
+    throw std::runtime_error("Data is not a blosc container");
+  if (p[4] > BLXC_VERSION)
+    throw std::runtime_error("Blosc container was written by a newer version of the package");
+  container_index result;
+  result.chunk_size = get_u32_le(p + 8);
+  result.footer = container_parse_footer(p + size - BLXC_FOOTER_SIZE);
+  const container_footer &footer = result.footer;
+  size_t index_space = size - BLXC_HEADER_SIZE - BLXC_INDEX_SIZE - BLXC_FOOTER_SIZE;
+  if (footer.nchunks > index_space / BLXC_ENTRY_SIZE ||
+      footer.index_offset != size - BLXC_FOOTER_SIZE - BLXC_INDEX_SIZE -
+        footer.nchunks * BLXC_ENTRY_SIZE ||
+      memcmp(p + footer.index_offset, "BLXI", 4) != 0 ||
+      (result.chunk_size == 0 && footer.nchunks > 0) ||
+      (result.chunk_size > 0 && footer.nchunks !=
+        (footer.nbytes + result.chunk_size - 1) / result.chunk_size))
+    throw std::runtime_error("Blosc container is incomplete or corrupt");
+  const uint8_t *entry = p + footer.index_offset + BLXC_INDEX_SIZE;
+  for (uint64_t i = 0; i < footer.nchunks; i++, entry += BLXC_ENTRY_SIZE) {
+    container_entry e = {get_u64_le(entry), get_u64_le(entry + 8)};
+    if (e.offset < BLXC_HEADER_SIZE || e.offset > footer.index_offset ||
+        e.cbytes > footer.index_offset - e.offset)
+      throw std::runtime_error("Blosc container is incomplete or corrupt");
+    result.entries.push_back(e);
+  }
+  return result;
+}
+
+size_t container_chunk_nbytes(const container_index &index, size_t i) {
+  uint64_t start = (uint64_t)i * index.chunk_size;
+  return (size_t)std::min<uint64_t>(index.chunk_size, index.footer.nbytes - start);
+}
+
+container_file::container_file(const std::string &path, bool write) : path(path) {
+  f = std::fopen(path.c_str(), write ? "wb" : "rb");
+  if (f == nullptr) throw std::runtime_error("Failed to open file '" + path + "'");
+}
+
+container_file::~container_file() {
+  if (f != nullptr) std::fclose(f);
+}
+
+container_sink container_file::sink() {
+  return [this](const uint8_t *p, size_t n) {
+    if (std::fwrite(p, 1, n, f) != n)
+      throw std::runtime_error("Failed to write file '" + path + "'");
+  };
+}
+
+container_source container_file::source() {
+  return [this](uint8_t *p, size_t n) {
+    size_t result = std::fread(p, 1, n, f);
+    if (result < n && std::ferror(f))
+      throw std::runtime_error("Failed to read file '" + path + "'");
+    return result;
+  };
+}
+
+void container_file::close() {
+  int result = std::fclose(f);
+  f = nullptr;
+  if (result != 0) throw std::runtime_error("Failed to write file '" + path + "'");
+}
+
+container_writer::container_writer(container_sink sink, const std::string &compressor,
+                                   int level, int doshuffle, int typesize,
+                                   size_t chunk_size, int nthreads) :
+  sink(sink), compressor(compressor), level(level), doshuffle(doshuffle),
+  typesize(typesize), chunk_size(chunk_size),
+  max_pending(2 * (size_t)std::max(nthreads, 1)),
+  queue(nthreads, (size_t)std::max(nthreads, 1)) {
+  if (chunk_size == 0 || chunk_size > (size_t)BACKEND_MAX_BUFFERSIZE)
+    throw std::runtime_error("Invalid chunk size");
+  uint8_t header[BLXC_HEADER_SIZE] = {0};
+  memcpy(header, "BLXC", 4);
+  header[4] = BLXC_VERSION;
+  put_u32_le(header + 8, (uint32_t)chunk_size);
+  put(header, BLXC_HEADER_SIZE);
+  buffer.reserve(chunk_size);
+}
+
+void container_writer::write(const uint8_t *p, size_t n) {
+  while (n > 0) {
+    size_t len = std::min(n, chunk_size - buffer.size());
+    buffer.insert(buffer.end(), p, p + len);
+    p += len;
+    n -= len;
+    if (buffer.size() == chunk_size) submit();
+  }
+}
+
+void container_writer::finish() {
+  if (!buffer.empty()) submit();
+  drain(0);
+  uint64_t index_offset = offset;
+  std::vector<uint8_t> trailer(BLXC_INDEX_SIZE + BLXC_ENTRY_SIZE * index.size() +
+                               BLXC_FOOTER_SIZE, 0);
+  uint8_t *p = trailer.data();
+  memcpy(p, "BLXI", 4);
+  p += BLXC_INDEX_SIZE;
+  for (auto &entry : index) {
+    put_u64_le(p, entry.offset);
+    put_u64_le(p + 8, entry.cbytes);
+    p += BLXC_ENTRY_SIZE;
+  }
+  put_u64_le(p, index_offset);
+  put_u64_le(p + 8, (uint64_t)index.size());
+  put_u64_le(p + 16, nbytes);
+  memcpy(p + 24, "BLXE", 4);
+  put(trailer.data(), trailer.size());
+}
+
+void container_writer::submit() {
+  auto input = std::make_shared<std::vector<uint8_t>>(std::move(buffer));
+  auto result = std::make_shared<std::promise<std::vector<uint8_t>>>();
+  buffer = std::vector<uint8_t>();
+  buffer.reserve(chunk_size);
+  nbytes += input->size();
+  pending.push_back(result->get_future());
+  queue.submit([input, result, compressor = compressor, level = level,
+                doshuffle = doshuffle, typesize = typesize]() {
+    try {
+      result->set_value(container_compress_chunk(input->data(), input->size(),
+                                                 compressor, level, doshuffle,
+                                                 typesize));
+    } catch (...) {
+      result->set_exception(std::current_exception());
+    }
+  });
+  drain(max_pending);
+}
+
+void container_writer::drain(size_t keep) {
+  while (!pending.empty() &&
+         (pending.size() > keep ||
+          pending.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+    std::vector<uint8_t> chunk = pending.front().get();
+    pending.pop_front();
+    index.push_back({offset, (uint64_t)chunk.size()});
+    put(chunk.data(), chunk.size());
+  }
+}
+
+void container_writer::put(const uint8_t *p, size_t n) {
+  sink(p, n);
+  offset += n;
+}
+
+container_reader::container_reader(container_source source, int nthreads) :
+  source(source), max_pending(2 * (size_t)std::max(nthreads, 1)),
+  queue(nthreads, (size_t)std::max(nthreads, 1)) {
+  uint8_t header[BLXC_HEADER_SIZE];
+  get(header, BLXC_HEADER_SIZE);
+  if (memcmp(header, "BLXC", 4) != 0)
+    throw std::runtime_error("Data is not a blosc container");
+  if (header[4] > BLXC_VERSION)
+    throw std::runtime_error("Blosc container was written by a newer version of the package");
+  chunk_size = get_u32_le(header + 8);
+  fill();
+}
+
+size_t container_reader::read(uint8_t *p, size_t n) {
+  size_t done = 0;
+  while (done < n) {
+    if (position == current.size()) {
+      if (pending.empty()) break;
+      current = pending.front().get();
+      pending.pop_front();
+      position = 0;
+      fill();
+      continue;
+    }
+    size_t len = std::min(n - done, current.size() - position);
+    memcpy(p + done, current.data() + position, len);
+    position += len;
+    done += len;
+  }
+  return done;
+}
+
+void container_reader::fill() {
+  // The index is followed by at least the footer, so reading a chunk's
+  // header can never run beyond the end of a valid container
+  const size_t head_size = 16;
+  while (!source_done && pending.size() < max_pending) {
+    uint8_t head[head_size];
+    get(head, head_size);
+    if (memcmp(head, "BLXI", 4) == 0) {
+      source_done = true;
+      break;
+    }
+    size_t cbytes = get_u32_le(head + 12);
+    if (cbytes < head_size || cbytes > chunk_size + BACKEND_MAX_OVERHEAD)
+      throw std::runtime_error("Corrupt chunk in container");
+    auto input = std::make_shared<std::vector<uint8_t>>(cbytes);
+    memcpy(input->data(), head, head_size);
+    get(input->data() + head_size, cbytes - head_size);
+    auto result = std::make_shared<std::promise<std::vector<uint8_t>>>();
+    pending.push_back(result->get_future());
+    queue.submit([input, result, max_nbytes = chunk_size]() {
+      try {
+        result->set_value(container_decompress_chunk(input->data(), input->size(),
+                                                     max_nbytes));
+      } catch (...) {
+        result->set_exception(std::current_exception());
+      }
+    });
+  }
+}
+
+void container_reader::get(uint8_t *p, size_t n) {
+  if (source(p, n) != n)
+    throw std::runtime_error("Unexpected end of blosc container");
+}
@@ -0,0 +1,167 @@
+#ifndef BLOSC_CONTAINER_H
+#define BLOSC_CONTAINER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include "pipeline.h"
+
+// A container stores a stream of data of arbitrary length as a sequence of
+// independently compressed chunks, such that it can be written and read
+// without holding all of the data in memory. It consists of:
+//
+//   header: magic "BLXC" (4 bytes), version (1 byte), 3 reserved bytes,
+//           uncompressed chunk size (uint32 LE), 4 reserved bytes
+//   chunks: blosc buffers of `chunk size` uncompressed bytes (the last one
+//           may be smaller), stored back to back
+//   index:  magic "BLXI" (4 bytes), 4 reserved bytes, followed by the
+//           offset (uint64 LE) and compressed size (uint64 LE) of each chunk
+//   footer: offset of the index (uint64 LE), number of chunks (uint64 LE),
+//           total uncompressed size (uint64 LE), magic "BLXE" (4 bytes) and
+//           4 reserved bytes
+//
+// Chunks are self-delimiting (blosc buffers record their compressed size),
+// so containers can be read sequentially from streams. The index and footer
+// allow for random access to chunks in files. A blosc buffer starts with its
+// format version (2), so it can never be mistaken for the index.
+
+#define BLXC_VERSION      1
+#define BLXC_HEADER_SIZE  16
+#define BLXC_INDEX_SIZE   8
+#define BLXC_ENTRY_SIZE   16
+#define BLXC_FOOTER_SIZE  32
+
+// Writes `n` bytes to the destination of a container. Called on the main
+// thread only; throws a `std::runtime_error` on failure.
+typedef std::function<void(const uint8_t *p, size_t n)> container_sink;
+// Reads up to `n` bytes from the source of a container and returns the
+// number of bytes read, which is less than `n` only at the end of the
+// source. Called on the main thread only.
+typedef std::function<size_t(uint8_t *p, size_t n)> container_source;
+
+// Sink and source for a file, which is closed when the object is destroyed
+class container_file {
+public:
+  container_file(const std::string &path, bool write);
+  ~container_file();
+
+  container_file(const container_file&) = delete;
+  container_file& operator=(const container_file&) = delete;
+
+  container_sink sink();
+  container_source source();
+  // Closes the file, throwing an error when written data could not be flushed
+  void close();
+
+private:
+  std::string path;
+  FILE *f = nullptr;
+};
+
+typedef struct {
+  uint64_t offset;
+  uint64_t cbytes;
+} container_entry;
+
+typedef struct {
+  uint64_t index_offset;
+  uint64_t nchunks;
+  uint64_t nbytes;
+} container_footer;
+
+// Parses the footer at `p`, i.e. the last `BLXC_FOOTER_SIZE` bytes of a
+// container. Throws a `std::runtime_error` when it is invalid.
+container_footer container_parse_footer(const uint8_t *p);
+
+typedef struct {
+  size_t chunk_size;
+  container_footer footer;
+  std::vector<container_entry> entries;
+} container_index;
+
+// Parses and validates the header, index and footer of the container of
+// `size` bytes at `p`. Chunks themselves are not validated.
+container_index container_parse_index(const uint8_t *p, size_t size);
+// Uncompressed size of chunk `i`
+size_t container_chunk_nbytes(const container_index &index, size_t i);
+
+// Writes a container to `sink`. Chunks are compressed by `nthreads` worker
+// threads while data is being written, and passed to `sink` in order.
+class container_writer {
+public:
+  container_writer(container_sink sink, const std::string &compressor, int level,
+                   int doshuffle, int typesize, size_t chunk_size, int nthreads);
+
+  container_writer(const container_writer&) = delete;
+  container_writer& operator=(const container_writer&) = delete;
+
+  void write(const uint8_t *p, size_t n);
+  // Compresses the remaining data and writes the index and footer
+  void finish();
+
+private:
+  typedef std::future<std::vector<uint8_t>> pending_chunk;
+
+  container_sink sink;
+  std::string compressor;
+  int level, doshuffle, typesize;
+  size_t chunk_size, max_pending;
+  uint64_t offset = 0, nbytes = 0;
+  std::vector<uint8_t> buffer;
+  std::vector<container_entry> index;
+  std::deque<pending_chunk> pending;
+  task_queue queue;
+
+  void submit();
+  // Writes finished chunks, waiting for them while more than `keep` are pending
+  void drain(size_t keep);
+  void put(const uint8_t *p, size_t n);
+};
+
+// Reads the data stored in a container sequentially from `source`. Chunks
+// are read ahead and decompressed by `nthreads` worker threads.
+class container_reader {
+public:
+  container_reader(container_source source, int nthreads);
+
+  container_reader(const container_reader&) = delete;
+  container_reader& operator=(const container_reader&) = delete;
+
+  // Reads up to `n` bytes into `p`, returns the number of bytes read
+  size_t read(uint8_t *p, size_t n);
+  // Uncompressed size of the chunks of the container
+  size_t chunk_bytes() const {
+    return chunk_size;
+  }
+
+private:
+  typedef std::future<std::vector<uint8_t>> pending_chunk;
+
+  container_source source;
+  size_t chunk_size, max_pending;
+  bool source_done = false;
+  std::vector<uint8_t> current;
+  size_t position = 0;
+  std::deque<pending_chunk> pending;
+  task_queue queue;
+
+  // Reads compressed chunks and submits them, until `max_pending` chunks
+  // are pending or all chunks were read
+  void fill();
+  void get(uint8_t *p, size_t n);
+};
+
+// Compresses or decompresses a single chunk. Throws `std::runtime_error`
+// on failure, so it can be used by workers.
+std::vector<uint8_t> container_compress_chunk(const uint8_t *p, size_t n,
+                                              const std::string &compressor,
+                                              int level, int doshuffle, int typesize);
+std::vector<uint8_t> container_decompress_chunk(const uint8_t *p, size_t n,
+                                                size_t max_nbytes);
+
+#endif /* BLOSC_CONTAINER_H */
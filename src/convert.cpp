@@ -0,0 +1,272 @@
+#include <cpp11.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include "dtype.h"
+
+using namespace cpp11;
+
+// Conversion between dtypes, straight from raw data to raw data. Each
+// element is loaded in the host's byte order, converted and stored in the
+// byte order of the target, without an R vector in between. 64 bit
+// integers are therefore converted exactly.
+
+// Storage types of elements that are represented by another type in
+// conversions: booleans and half precision floats
+struct b1_t { uint8_t v; };
+struct f2_t { uint16_t bits; };
+
+template <typename S> struct item {
+  typedef S value;
+  static value load(S s) { return s; }
+  static S store(value v) { return v; }
+};
+
+template <> struct item<b1_t> {
+  typedef bool value;
+  static value load(b1_t s) { return s.v != 0; }
+  static b1_t store(value v) { return {(uint8_t)(v ? 1 : 0)}; }
+};
+
+template <> struct item<f2_t> {
+  typedef double value;
+  static value load(f2_t s) { return float16_to_double(s.bits); }
+  static f2_t store(value v) { return {double_to_float16(v)}; }
+};
+
+template <typename S>
+static inline S load_bytes(const uint8_t *p, bool swap) {
+  S s;
+  if (!swap) {
+    memcpy(&s, p, sizeof(S));
+  } else {
+    uint8_t b[sizeof(S)];
+    for (size_t j = 0; j < sizeof(S); j++) b[j] = p[sizeof(S) - j - 1];
+    memcpy(&s, b, sizeof(S));
+  }
+  return s;
+}
+
+template <typename S>
+static inline void store_bytes(uint8_t *p, S s, bool swap) {
+  if (!swap) {
+    memcpy(p, &s, sizeof(S));
+  } else {
+    uint8_t b[sizeof(S)];
+    memcpy(b, &s, sizeof(S));
+    for (size_t j = 0; j < sizeof(S); j++) p[j] = b[sizeof(S) - j - 1];
+  }
+}
+
+// Converts `v` to `out`, returns `false` when it is out of the range of
+// `T`. Floating point values are truncated towards zero when converted to
+// integers.
+template <typename F, typename T>
+static inline bool cast_value(F v, T &out) {
+  if constexpr (std::is_same<T, bool>::value) {
+    out = v != 0;
+  } else if constexpr (std::is_floating_point<T>::value) {
+    out = (T)v;
+  } else if constexpr (std::is_floating_point<F>::value) {
+    double d = std::trunc((double)v);
+    if (!(d >= (double)std::numeric_limits<T>::lowest() &&
+          d < std::ldexp(1.0, std::numeric_limits<T>::digits)))
+      return false;
+    out = (T)d;
+  } else {
+    if constexpr (std::is_signed<F>::value) {
+      if (v < 0) {
+        if (!std::is_signed<T>::value ||
+            (int64_t)v < (int64_t)std::numeric_limits<T>::lowest())
+          return false;
+        out = (T)v;
+        return true;
+      }
+    }
+    if ((uint64_t)v > (uint64_t)std::numeric_limits<T>::max()) return false;
+    out = (T)v;
+  }
+  return true;
+}
+
+// A value given from R. `integer64` values are kept as 64 bit integers,
+// such that values beyond 2^53 stay exact.
+typedef struct {
+  bool has;
+  bool is_int64;
+  double real;
+  int64_t int64;
+} convert_value;
+
+template <typename T>
+static inline bool cast_na(const convert_value &v, T &out) {
+  return v.is_int64 ? cast_value(v.int64, out) : cast_value(v.real, out);
+}
+
+// Missing values: elements equal to `from` (when given) are written as `to`
+// (when given)
+typedef struct {
+  convert_value from;
+  convert_value to;
+} convert_na;
+
+static const char *missing_error =
+  "Missing values cannot be represented by `to`. Specify `na_to`";
+
+// Converts `n` elements of storage type `F` to `T`. NaN is missing as well.
+template <typename F, typename T>
+static void convert_items(const uint8_t *src, size_t n, bool swap_in, bool swap_out,
+                          uint8_t *dest, const convert_na &na) {
+  typedef typename item<F>::value FV;
+  typedef typename item<T>::value TV;
+  FV na_from{};
+  // Values that `F` cannot represent never occur
+  bool has_from = na.from.has && cast_na(na.from, na_from);
+  TV na_to{};
+  bool has_to = na.to.has;
+  if (has_to && !cast_na(na.to, na_to))
+    throw std::runtime_error("`na_to` is out of the range of `to`");
+  if constexpr (std::is_floating_point<TV>::value) {
+    if (!has_to) na_to = std::numeric_limits<TV>::quiet_NaN();
+    has_to = true;
+  }
+  for (size_t i = 0; i < n; i++) {
+    FV v = item<F>::load(load_bytes<F>(src + i * sizeof(F), swap_in));
+    TV out;
+    if (v != v || (has_from && v == na_from)) {
+      if (!has_to) throw std::runtime_error(missing_error);
+      out = na_to;
+    } else if (!cast_value(v, out)) {
+      throw std::runtime_error("Values are out of the range of `to`");
+    }
+    store_bytes<T>(dest + i * sizeof(T), item<T>::store(out), swap_out);
+  }
+}
+
+// Calls `fn` with a value of the storage type of (boolean, integer or
+// floating point) `dt`. Complex numbers are stored as pairs of floats.
+template <typename Fn>
+static void with_storage_type(const blosc_dtype &dt, Fn fn) {
+  char type = dt.main_type;
+  int size = dt.byte_size;
+  if (type == 'b') fn(b1_t());
+  else if (type == 'i' && size == 1) fn(int8_t());
+  else if (type == 'i' && size == 2) fn(int16_t());
+  else if (type == 'i' && size == 4) fn(int32_t());
+  else if (type == 'i') fn(int64_t());
+  else if (type == 'u' && size == 1) fn(uint8_t());
+  else if (type == 'u' && size == 2) fn(uint16_t());
+  else if (type == 'u' && size == 4) fn(uint32_t());
+  else if (type == 'u') fn(uint64_t());
+  else if (type == 'f' && size == 2) fn(f2_t());
+  else if ((type == 'f' && size == 4) || (type == 'c' && size == 8)) fn(float());
+  else fn(double());
+}
+
+// Rescales date times or time differences by multiplying with `mul` or
+// (floor) dividing by `div`. NaT (the smallest 64 bit integer) is missing,
+// and is written as NaT unless `na.to` is given.
+static void convert_datetime(const uint8_t *src, size_t n, bool swap_in, bool swap_out,
+                             uint8_t *dest, int64_t mul, int64_t div,
+                             const convert_na &na) {
+  const int64_t nat = std::numeric_limits<int64_t>::min();
+  int64_t na_from = nat, na_to = nat;
+  bool has_from = na.from.has && cast_na(na.from, na_from);
+  if (na.to.has && !cast_na(na.to, na_to))
+    throw std::runtime_error("`na_to` is out of the range of `to`");
+  for (size_t i = 0; i < n; i++) {
+    int64_t v = load_bytes<int64_t>(src + i * 8, swap_in);
+    if (v == nat || (has_from && v == na_from)) {
+      v = na_to;
+    } else if (mul > 1) {
+      if (v <= nat / mul || v > std::numeric_limits<int64_t>::max() / mul)
+        throw std::runtime_error("Values are out of the range of `to`");
+      v *= mul;
+    } else if (div > 1) {
+      int64_t q = v / div;
+      if (v % div != 0 && v < 0) q--;
+      v = q;
+    }
+    store_bytes<int64_t>(dest + i * 8, v, swap_out);
+  }
+}
+
+// Converts fixed width strings to another width, truncating or padding them
+// with zeros. Characters of 'U' strings are 4 byte code points.
+static void convert_strings(const uint8_t *src, size_t n, const blosc_dtype &from,
+                            const blosc_dtype &to, uint8_t *dest) {
+  size_t unit = from.main_type == 'U' ? 4 : 1;
+  size_t wf = from.byte_size * unit, wt = to.byte_size * unit;
+  size_t len = std::min(wf, wt);
+  bool swap = unit == 4 && from.needs_byteswap != to.needs_byteswap;
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t *p = src + i * wf;
+    uint8_t *d = dest + i * wt;
+    memset(d + len, 0, wt - len);
+    if (!swap) {
+      memcpy(d, p, len);
+    } else {
+      for (size_t j = 0; j < len; j += 4)
+        store_bytes<uint32_t>(d + j, load_bytes<uint32_t>(p + j, true), false);
+    }
+  }
+}
+
+static bool is_numeric(const blosc_dtype &dt) {
+  return dt.main_type == 'b' || dt.main_type == 'i' || dt.main_type == 'u' ||
+    dt.main_type == 'f';
+}
+
+static convert_value na_value(doubles na) {
+  convert_value result = {na.size() > 0, (bool)Rf_inherits(as_sexp(na), "integer64"),
+                           0, 0};
+  if (result.has) {
+    result.real = na[0];
+    if (result.is_int64) memcpy(&result.int64, REAL(as_sexp(na)), sizeof(int64_t));
+  }
+  return result;
+}
+
+[[cpp11::register]]
+raws dtype_convert_(raws data, std::string from, std::string to, doubles na_from,
+                    doubles na_to) {
+  blosc_dtype df = prepare_dtype(from), dt = prepare_dtype(to);
+  size_t item_from = (size_t)dtype_item_size(df), item_to = (size_t)dtype_item_size(dt);
+  if ((size_t)data.size() % item_from != 0)
+    stop("Raw data size needs to be multitude of data type size");
+  size_t n = (size_t)data.size() / item_from;
+  convert_na na = {na_value(na_from), na_value(na_to)};
+  writable::raws result((R_xlen_t)(n * item_to));
+  const uint8_t *src = (const uint8_t *)RAW(as_sexp(data));
+  uint8_t *dest = (uint8_t *)RAW(as_sexp(result));
+  bool swap_in = df.needs_byteswap, swap_out = dt.needs_byteswap;
+
+  if ((is_numeric(df) && is_numeric(dt)) || (df.main_type == 'c' && dt.main_type == 'c')) {
+    // Real and imaginary components are converted individually
+    if (df.main_type == 'c') n *= 2;
+    with_storage_type(df, [&](auto f) {
+      with_storage_type(dt, [&](auto t) {
+        convert_items<decltype(f), decltype(t)>(src, n, swap_in, swap_out, dest, na);
+      });
+    });
+  } else if ((df.main_type == 'M' || df.main_type == 'm') && df.main_type == dt.main_type) {
+    int64_t mul = 1, div = 1;
+    if (df.unit != dt.unit) {
+      // Calendar units ("Y" and "M") have no fixed length
+      if (df.unit_conversion <= 0 || dt.unit_conversion <= 0)
+        stop("Cannot convert date times from [%s] to [%s]", df.unit.c_str(),
+             dt.unit.c_str());
+      double ratio = df.unit_conversion / dt.unit_conversion;
+      if (ratio >= 1) mul = std::llround(ratio); else div = std::llround(1 / ratio);
+    }
+    convert_datetime(src, n, swap_in, swap_out, dest, mul, div, na);
+  } else if ((df.main_type == 'S' || df.main_type == 'U') && df.main_type == dt.main_type) {
+    convert_strings(src, n, df, dt, dest);
+  } else {
+    stop("Cannot convert from '%s' to '%s'", from.c_str(), to.c_str());
+  }
+  return result;
+}
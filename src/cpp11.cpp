@@ -5,6 +5,13 @@
 #include "cpp11/declarations.hpp"
 #include <R_ext/Visibility.h>
 
+// block_cache.cpp
+list blosc_block_cache_(double max_bytes);
+extern "C" SEXP _blosc_blosc_block_cache_(SEXP max_bytes) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_block_cache_(cpp11::as_cpp<cpp11::decay_t<double>>(max_bytes)));
+  END_CPP11
+}
 // blosc-feats.cpp
 list blosc_info_(raws data);
 extern "C" SEXP _blosc_blosc_info_(SEXP data) {
@@ -12,18 +19,159 @@ extern "C" SEXP _blosc_blosc_info_(SEXP data) {
     return cpp11::as_sexp(blosc_info_(cpp11::as_cpp<cpp11::decay_t<raws>>(data)));
   END_CPP11
 }
+// blosc-feats.cpp
+list blosc_backend_();
+extern "C" SEXP _blosc_blosc_backend_() {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_backend_());
+  END_CPP11
+}
+// blosc-feats.cpp
+list blosc_capabilities_();
+extern "C" SEXP _blosc_blosc_capabilities_() {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_capabilities_());
+  END_CPP11
+}
+// blosc-feats.cpp
+list blosc_self_test_(double size, std::string compressor, int nthreads);
+extern "C" SEXP _blosc_blosc_self_test_(SEXP size, SEXP compressor, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_self_test_(cpp11::as_cpp<cpp11::decay_t<double>>(size), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// cache.cpp
+SEXP blosc_cache_new_(double max_bytes, std::string compressor, int level);
+extern "C" SEXP _blosc_blosc_cache_new_(SEXP max_bytes, SEXP compressor, SEXP level) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_cache_new_(cpp11::as_cpp<cpp11::decay_t<double>>(max_bytes), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level)));
+  END_CPP11
+}
+// cache.cpp
+bool blosc_cache_set_(SEXP cache, std::string key, SEXP value, bool serialized);
+extern "C" SEXP _blosc_blosc_cache_set_(SEXP cache, SEXP key, SEXP value, SEXP serialized) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_cache_set_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(cache), cpp11::as_cpp<cpp11::decay_t<std::string>>(key), cpp11::as_cpp<cpp11::decay_t<SEXP>>(value), cpp11::as_cpp<cpp11::decay_t<bool>>(serialized)));
+  END_CPP11
+}
+// cache.cpp
+SEXP blosc_cache_get_(SEXP cache, std::string key);
+extern "C" SEXP _blosc_blosc_cache_get_(SEXP cache, SEXP key) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_cache_get_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(cache), cpp11::as_cpp<cpp11::decay_t<std::string>>(key)));
+  END_CPP11
+}
+// cache.cpp
+bool blosc_cache_remove_(SEXP cache, std::string key);
+extern "C" SEXP _blosc_blosc_cache_remove_(SEXP cache, SEXP key) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_cache_remove_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(cache), cpp11::as_cpp<cpp11::decay_t<std::string>>(key)));
+  END_CPP11
+}
+// cache.cpp
+void blosc_cache_clear_(SEXP cache);
+extern "C" SEXP _blosc_blosc_cache_clear_(SEXP cache) {
+  BEGIN_CPP11
+    blosc_cache_clear_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(cache));
+    return R_NilValue;
+  END_CPP11
+}
+// cache.cpp
+list blosc_cache_stats_(SEXP cache);
+extern "C" SEXP _blosc_blosc_cache_stats_(SEXP cache) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_cache_stats_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(cache)));
+  END_CPP11
+}
+// compress.cpp
+raws blosc_compress_dat(SEXP data, std::string compressor, int level, int doshuffle, int typesize, strings filters, doubles params, bool big_endian, bool is_signed, raws dict, std::string stats);
+extern "C" SEXP _blosc_blosc_compress_dat(SEXP data, SEXP compressor, SEXP level, SEXP doshuffle, SEXP typesize, SEXP filters, SEXP params, SEXP big_endian, SEXP is_signed, SEXP dict, SEXP stats) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_compress_dat(cpp11::as_cpp<cpp11::decay_t<SEXP>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(typesize), cpp11::as_cpp<cpp11::decay_t<strings>>(filters), cpp11::as_cpp<cpp11::decay_t<doubles>>(params), cpp11::as_cpp<cpp11::decay_t<bool>>(big_endian), cpp11::as_cpp<cpp11::decay_t<bool>>(is_signed), cpp11::as_cpp<cpp11::decay_t<raws>>(dict), cpp11::as_cpp<cpp11::decay_t<std::string>>(stats)));
+  END_CPP11
+}
+// compress.cpp
+raws blosc_compress_factor_(integers codes, strings levels, bool ordered, std::string compressor, int level, int doshuffle);
+extern "C" SEXP _blosc_blosc_compress_factor_(SEXP codes, SEXP levels, SEXP ordered, SEXP compressor, SEXP level, SEXP doshuffle) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_compress_factor_(cpp11::as_cpp<cpp11::decay_t<integers>>(codes), cpp11::as_cpp<cpp11::decay_t<strings>>(levels), cpp11::as_cpp<cpp11::decay_t<bool>>(ordered), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle)));
+  END_CPP11
+}
+// compress.cpp
+raws blosc_train_dict_(list samples, int dict_size);
+extern "C" SEXP _blosc_blosc_train_dict_(SEXP samples, SEXP dict_size) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_train_dict_(cpp11::as_cpp<cpp11::decay_t<list>>(samples), cpp11::as_cpp<cpp11::decay_t<int>>(dict_size)));
+  END_CPP11
+}
+// compress.cpp
+raws blosc_filter_dat(raws data, strings filters, doubles params, int typesize, bool big_endian, bool is_signed);
+extern "C" SEXP _blosc_blosc_filter_dat(SEXP data, SEXP filters, SEXP params, SEXP typesize, SEXP big_endian, SEXP is_signed) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_filter_dat(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<strings>>(filters), cpp11::as_cpp<cpp11::decay_t<doubles>>(params), cpp11::as_cpp<cpp11::decay_t<int>>(typesize), cpp11::as_cpp<cpp11::decay_t<bool>>(big_endian), cpp11::as_cpp<cpp11::decay_t<bool>>(is_signed)));
+  END_CPP11
+}
+// compress.cpp
+SEXP blosc_decompress_dat(raws data, raws dict);
+extern "C" SEXP _blosc_blosc_decompress_dat(SEXP data, SEXP dict) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_decompress_dat(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<raws>>(dict)));
+  END_CPP11
+}
+// compress.cpp
+SEXP blosc_decompress_native_(raws data, raws dict, std::string dtype, sexp na_value);
+extern "C" SEXP _blosc_blosc_decompress_native_(SEXP data, SEXP dict, SEXP dtype, SEXP na_value) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_decompress_native_(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<raws>>(dict), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value)));
+  END_CPP11
+}
+// compress.cpp
+SEXP blosc_decompress_integer64_(raws data, raws dict, std::string dtype, sexp na_value);
+extern "C" SEXP _blosc_blosc_decompress_integer64_(SEXP data, SEXP dict, SEXP dtype, SEXP na_value) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_decompress_integer64_(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<raws>>(dict), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value)));
+  END_CPP11
+}
+// compress.cpp
+SEXP blosc_compress_async_(SEXP data, std::string compressor, int level, int doshuffle, int typesize, strings filters, doubles params, bool big_endian, bool is_signed, SEXP dict);
+extern "C" SEXP _blosc_blosc_compress_async_(SEXP data, SEXP compressor, SEXP level, SEXP doshuffle, SEXP typesize, SEXP filters, SEXP params, SEXP big_endian, SEXP is_signed, SEXP dict) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_compress_async_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(typesize), cpp11::as_cpp<cpp11::decay_t<strings>>(filters), cpp11::as_cpp<cpp11::decay_t<doubles>>(params), cpp11::as_cpp<cpp11::decay_t<bool>>(big_endian), cpp11::as_cpp<cpp11::decay_t<bool>>(is_signed), cpp11::as_cpp<cpp11::decay_t<SEXP>>(dict)));
+  END_CPP11
+}
 // compress.cpp
-raws blosc_compress_dat(raws data, std::string compressor, int level, int doshuffle, int typesize);
-extern "C" SEXP _blosc_blosc_compress_dat(SEXP data, SEXP compressor, SEXP level, SEXP doshuffle, SEXP typesize) {
+SEXP blosc_decompress_async_(SEXP data, SEXP dict);
+extern "C" SEXP _blosc_blosc_decompress_async_(SEXP data, SEXP dict) {
   BEGIN_CPP11
-    return cpp11::as_sexp(blosc_compress_dat(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(typesize)));
+    return cpp11::as_sexp(blosc_decompress_async_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(data), cpp11::as_cpp<cpp11::decay_t<SEXP>>(dict)));
   END_CPP11
 }
 // compress.cpp
-raws blosc_decompress_dat(raws data);
-extern "C" SEXP _blosc_blosc_decompress_dat(SEXP data) {
+bool blosc_async_resolved_(SEXP handle);
+extern "C" SEXP _blosc_blosc_async_resolved_(SEXP handle) {
   BEGIN_CPP11
-    return cpp11::as_sexp(blosc_decompress_dat(cpp11::as_cpp<cpp11::decay_t<raws>>(data)));
+    return cpp11::as_sexp(blosc_async_resolved_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(handle)));
+  END_CPP11
+}
+// compress.cpp
+SEXP blosc_async_value_(SEXP handle);
+extern "C" SEXP _blosc_blosc_async_value_(SEXP handle) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_async_value_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(handle)));
+  END_CPP11
+}
+// connection.cpp
+SEXP blosc_connection_(std::string path, std::string mode, std::string compressor, int level, int doshuffle, int typesize, double chunk_size, int nthreads);
+extern "C" SEXP _blosc_blosc_connection_(SEXP path, SEXP mode, SEXP compressor, SEXP level, SEXP doshuffle, SEXP typesize, SEXP chunk_size, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_connection_(cpp11::as_cpp<cpp11::decay_t<std::string>>(path), cpp11::as_cpp<cpp11::decay_t<std::string>>(mode), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(typesize), cpp11::as_cpp<cpp11::decay_t<double>>(chunk_size), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// convert.cpp
+raws dtype_convert_(raws data, std::string from, std::string to, doubles na_from, doubles na_to);
+extern "C" SEXP _blosc_dtype_convert_(SEXP data, SEXP from, SEXP to, SEXP na_from, SEXP na_to) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(dtype_convert_(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(from), cpp11::as_cpp<cpp11::decay_t<std::string>>(to), cpp11::as_cpp<cpp11::decay_t<doubles>>(na_from), cpp11::as_cpp<cpp11::decay_t<doubles>>(na_to)));
   END_CPP11
 }
 // dtype.cpp
@@ -48,22 +196,179 @@ extern "C" SEXP _blosc_dtype_to_r_(SEXP data, SEXP dtype, SEXP na_value) {
   END_CPP11
 }
 // dtype.cpp
+bool dtype_is_native_(SEXP data, std::string dtype, sexp na_value);
+extern "C" SEXP _blosc_dtype_is_native_(SEXP data, SEXP dtype, SEXP na_value) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(dtype_is_native_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value)));
+  END_CPP11
+}
+// dtype.cpp
+SEXP dtype_to_integer64_(raws data, std::string dtype, sexp na_value);
+extern "C" SEXP _blosc_dtype_to_integer64_(SEXP data, SEXP dtype, SEXP na_value) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(dtype_to_integer64_(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value)));
+  END_CPP11
+}
+// dtype.cpp
+raws integer64_to_dtype_(doubles data, std::string dtype, sexp na_value);
+extern "C" SEXP _blosc_integer64_to_dtype_(SEXP data, SEXP dtype, SEXP na_value) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(integer64_to_dtype_(cpp11::as_cpp<cpp11::decay_t<doubles>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value)));
+  END_CPP11
+}
+// dtype.cpp
 raws r_to_dtype_(sexp data, std::string dtype, sexp na_value);
 extern "C" SEXP _blosc_r_to_dtype_(SEXP data, SEXP dtype, SEXP na_value) {
   BEGIN_CPP11
     return cpp11::as_sexp(r_to_dtype_(cpp11::as_cpp<cpp11::decay_t<sexp>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value)));
   END_CPP11
 }
+// file.cpp
+double blosc_compress_file_(std::string input, std::string output, std::string compressor, int level, int doshuffle, int typesize, double chunk_size, int nthreads);
+extern "C" SEXP _blosc_blosc_compress_file_(SEXP input, SEXP output, SEXP compressor, SEXP level, SEXP doshuffle, SEXP typesize, SEXP chunk_size, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_compress_file_(cpp11::as_cpp<cpp11::decay_t<std::string>>(input), cpp11::as_cpp<cpp11::decay_t<std::string>>(output), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(typesize), cpp11::as_cpp<cpp11::decay_t<double>>(chunk_size), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// file.cpp
+double blosc_decompress_file_(std::string input, std::string output, int nthreads);
+extern "C" SEXP _blosc_blosc_decompress_file_(SEXP input, SEXP output, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_decompress_file_(cpp11::as_cpp<cpp11::decay_t<std::string>>(input), cpp11::as_cpp<cpp11::decay_t<std::string>>(output), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// file.cpp
+double blosc_recompress_file_(std::string input, std::string output, std::string compressor, int level, int doshuffle, int typesize, double chunk_size, int nthreads);
+extern "C" SEXP _blosc_blosc_recompress_file_(SEXP input, SEXP output, SEXP compressor, SEXP level, SEXP doshuffle, SEXP typesize, SEXP chunk_size, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_recompress_file_(cpp11::as_cpp<cpp11::decay_t<std::string>>(input), cpp11::as_cpp<cpp11::decay_t<std::string>>(output), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(typesize), cpp11::as_cpp<cpp11::decay_t<double>>(chunk_size), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// file.cpp
+raws blosc_read_file_(std::string input, double offset, double length, int nthreads);
+extern "C" SEXP _blosc_blosc_read_file_(SEXP input, SEXP offset, SEXP length, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_read_file_(cpp11::as_cpp<cpp11::decay_t<std::string>>(input), cpp11::as_cpp<cpp11::decay_t<double>>(offset), cpp11::as_cpp<cpp11::decay_t<double>>(length), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// recompress.cpp
+list blosc_recompress_(list data, std::string compressor, int level, int doshuffle, int typesize, int nthreads);
+extern "C" SEXP _blosc_blosc_recompress_(SEXP data, SEXP compressor, SEXP level, SEXP doshuffle, SEXP typesize, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_recompress_(cpp11::as_cpp<cpp11::decay_t<list>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(typesize), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// reduce.cpp
+double blosc_reduce_(raws data, std::string dtype, std::string fun, sexp na_value, bool na_rm, int nthreads);
+extern "C" SEXP _blosc_blosc_reduce_(SEXP data, SEXP dtype, SEXP fun, SEXP na_value, SEXP na_rm, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_reduce_(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<std::string>>(fun), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value), cpp11::as_cpp<cpp11::decay_t<bool>>(na_rm), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// region.cpp
+sexp blosc_decompress_region_(raws data, std::string dtype, integers chunk_shape, integers start, integers count, integers step, std::string order, sexp na_value);
+extern "C" SEXP _blosc_blosc_decompress_region_(SEXP data, SEXP dtype, SEXP chunk_shape, SEXP start, SEXP count, SEXP step, SEXP order, SEXP na_value) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_decompress_region_(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<integers>>(chunk_shape), cpp11::as_cpp<cpp11::decay_t<integers>>(start), cpp11::as_cpp<cpp11::decay_t<integers>>(count), cpp11::as_cpp<cpp11::decay_t<integers>>(step), cpp11::as_cpp<cpp11::decay_t<std::string>>(order), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value)));
+  END_CPP11
+}
+// serialize.cpp
+SEXP blosc_serialize_(SEXP object, SEXP con, std::string path, bool xdr, std::string compressor, int level, int doshuffle, int typesize, double chunk_size, int nthreads);
+extern "C" SEXP _blosc_blosc_serialize_(SEXP object, SEXP con, SEXP path, SEXP xdr, SEXP compressor, SEXP level, SEXP doshuffle, SEXP typesize, SEXP chunk_size, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_serialize_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(object), cpp11::as_cpp<cpp11::decay_t<SEXP>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(path), cpp11::as_cpp<cpp11::decay_t<bool>>(xdr), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(typesize), cpp11::as_cpp<cpp11::decay_t<double>>(chunk_size), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// serialize.cpp
+SEXP blosc_unserialize_(SEXP data, SEXP con, std::string path, int nthreads);
+extern "C" SEXP _blosc_blosc_unserialize_(SEXP data, SEXP con, SEXP path, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_unserialize_(cpp11::as_cpp<cpp11::decay_t<SEXP>>(data), cpp11::as_cpp<cpp11::decay_t<SEXP>>(con), cpp11::as_cpp<cpp11::decay_t<std::string>>(path), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// which.cpp
+SEXP blosc_which_(raws data, std::string dtype, std::string op, double lower, double upper, sexp na_value, bool logical, int nthreads);
+extern "C" SEXP _blosc_blosc_which_(SEXP data, SEXP dtype, SEXP op, SEXP lower, SEXP upper, SEXP na_value, SEXP logical, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(blosc_which_(cpp11::as_cpp<cpp11::decay_t<raws>>(data), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<std::string>>(op), cpp11::as_cpp<cpp11::decay_t<double>>(lower), cpp11::as_cpp<cpp11::decay_t<double>>(upper), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value), cpp11::as_cpp<cpp11::decay_t<bool>>(logical), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// zarr.cpp
+sexp zarr_read_chunks_(strings chunk_files, integers chunk_coords, list selection, integers chunk_shape, std::string dtype, std::string order, bool compressed, sexp fill, sexp na_value, int nthreads);
+extern "C" SEXP _blosc_zarr_read_chunks_(SEXP chunk_files, SEXP chunk_coords, SEXP selection, SEXP chunk_shape, SEXP dtype, SEXP order, SEXP compressed, SEXP fill, SEXP na_value, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(zarr_read_chunks_(cpp11::as_cpp<cpp11::decay_t<strings>>(chunk_files), cpp11::as_cpp<cpp11::decay_t<integers>>(chunk_coords), cpp11::as_cpp<cpp11::decay_t<list>>(selection), cpp11::as_cpp<cpp11::decay_t<integers>>(chunk_shape), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<std::string>>(order), cpp11::as_cpp<cpp11::decay_t<bool>>(compressed), cpp11::as_cpp<cpp11::decay_t<sexp>>(fill), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// zarr.cpp
+sexp zarr_read_shards_(strings shard_files, integers shard_coords, list selection, integers shard_shape, integers inner_shape, std::string dtype, bool compressed, bool index_at_end, bool index_crc, sexp fill, sexp na_value, int nthreads);
+extern "C" SEXP _blosc_zarr_read_shards_(SEXP shard_files, SEXP shard_coords, SEXP selection, SEXP shard_shape, SEXP inner_shape, SEXP dtype, SEXP compressed, SEXP index_at_end, SEXP index_crc, SEXP fill, SEXP na_value, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(zarr_read_shards_(cpp11::as_cpp<cpp11::decay_t<strings>>(shard_files), cpp11::as_cpp<cpp11::decay_t<integers>>(shard_coords), cpp11::as_cpp<cpp11::decay_t<list>>(selection), cpp11::as_cpp<cpp11::decay_t<integers>>(shard_shape), cpp11::as_cpp<cpp11::decay_t<integers>>(inner_shape), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<bool>>(compressed), cpp11::as_cpp<cpp11::decay_t<bool>>(index_at_end), cpp11::as_cpp<cpp11::decay_t<bool>>(index_crc), cpp11::as_cpp<cpp11::decay_t<sexp>>(fill), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// zarr.cpp
+int zarr_write_chunks_(sexp data, integers shape, strings chunk_files, integers chunk_coords, integers chunk_shape, std::string dtype, std::string order, bool compressed, std::string compressor, int level, int doshuffle, int blocksize, sexp fill, sexp na_value, int nthreads);
+extern "C" SEXP _blosc_zarr_write_chunks_(SEXP data, SEXP shape, SEXP chunk_files, SEXP chunk_coords, SEXP chunk_shape, SEXP dtype, SEXP order, SEXP compressed, SEXP compressor, SEXP level, SEXP doshuffle, SEXP blocksize, SEXP fill, SEXP na_value, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(zarr_write_chunks_(cpp11::as_cpp<cpp11::decay_t<sexp>>(data), cpp11::as_cpp<cpp11::decay_t<integers>>(shape), cpp11::as_cpp<cpp11::decay_t<strings>>(chunk_files), cpp11::as_cpp<cpp11::decay_t<integers>>(chunk_coords), cpp11::as_cpp<cpp11::decay_t<integers>>(chunk_shape), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<std::string>>(order), cpp11::as_cpp<cpp11::decay_t<bool>>(compressed), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(blocksize), cpp11::as_cpp<cpp11::decay_t<sexp>>(fill), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
+// zarr.cpp
+int zarr_write_shards_(sexp data, integers shape, strings shard_files, integers shard_coords, integers shard_shape, integers inner_shape, std::string dtype, bool compressed, std::string compressor, int level, int doshuffle, int blocksize, sexp fill, sexp na_value, int nthreads);
+extern "C" SEXP _blosc_zarr_write_shards_(SEXP data, SEXP shape, SEXP shard_files, SEXP shard_coords, SEXP shard_shape, SEXP inner_shape, SEXP dtype, SEXP compressed, SEXP compressor, SEXP level, SEXP doshuffle, SEXP blocksize, SEXP fill, SEXP na_value, SEXP nthreads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(zarr_write_shards_(cpp11::as_cpp<cpp11::decay_t<sexp>>(data), cpp11::as_cpp<cpp11::decay_t<integers>>(shape), cpp11::as_cpp<cpp11::decay_t<strings>>(shard_files), cpp11::as_cpp<cpp11::decay_t<integers>>(shard_coords), cpp11::as_cpp<cpp11::decay_t<integers>>(shard_shape), cpp11::as_cpp<cpp11::decay_t<integers>>(inner_shape), cpp11::as_cpp<cpp11::decay_t<std::string>>(dtype), cpp11::as_cpp<cpp11::decay_t<bool>>(compressed), cpp11::as_cpp<cpp11::decay_t<std::string>>(compressor), cpp11::as_cpp<cpp11::decay_t<int>>(level), cpp11::as_cpp<cpp11::decay_t<int>>(doshuffle), cpp11::as_cpp<cpp11::decay_t<int>>(blocksize), cpp11::as_cpp<cpp11::decay_t<sexp>>(fill), cpp11::as_cpp<cpp11::decay_t<sexp>>(na_value), cpp11::as_cpp<cpp11::decay_t<int>>(nthreads)));
+  END_CPP11
+}
 
 extern "C" {
 static const R_CallMethodDef CallEntries[] = {
-    {"_blosc_blosc_compress_dat",   (DL_FUNC) &_blosc_blosc_compress_dat,   5},
-    {"_blosc_blosc_decompress_dat", (DL_FUNC) &_blosc_blosc_decompress_dat, 1},
-    {"_blosc_blosc_info_",          (DL_FUNC) &_blosc_blosc_info_,          1},
-    {"_blosc_check_dt_units",       (DL_FUNC) &_blosc_check_dt_units,       0},
-    {"_blosc_dtype_to_list_",       (DL_FUNC) &_blosc_dtype_to_list_,       1},
-    {"_blosc_dtype_to_r_",          (DL_FUNC) &_blosc_dtype_to_r_,          3},
-    {"_blosc_r_to_dtype_",          (DL_FUNC) &_blosc_r_to_dtype_,          3},
+    {"_blosc_blosc_async_resolved_",       (DL_FUNC) &_blosc_blosc_async_resolved_,        1},
+    {"_blosc_blosc_async_value_",          (DL_FUNC) &_blosc_blosc_async_value_,           1},
+    {"_blosc_blosc_backend_",              (DL_FUNC) &_blosc_blosc_backend_,               0},
+    {"_blosc_blosc_block_cache_",          (DL_FUNC) &_blosc_blosc_block_cache_,           1},
+    {"_blosc_blosc_cache_clear_",          (DL_FUNC) &_blosc_blosc_cache_clear_,           1},
+    {"_blosc_blosc_cache_get_",            (DL_FUNC) &_blosc_blosc_cache_get_,             2},
+    {"_blosc_blosc_cache_new_",            (DL_FUNC) &_blosc_blosc_cache_new_,             3},
+    {"_blosc_blosc_cache_remove_",         (DL_FUNC) &_blosc_blosc_cache_remove_,          2},
+    {"_blosc_blosc_cache_set_",            (DL_FUNC) &_blosc_blosc_cache_set_,             4},
+    {"_blosc_blosc_cache_stats_",          (DL_FUNC) &_blosc_blosc_cache_stats_,           1},
+    {"_blosc_blosc_capabilities_",         (DL_FUNC) &_blosc_blosc_capabilities_,          0},
+    {"_blosc_blosc_compress_async_",       (DL_FUNC) &_blosc_blosc_compress_async_,       10},
+    {"_blosc_blosc_compress_dat",          (DL_FUNC) &_blosc_blosc_compress_dat,          11},
+    {"_blosc_blosc_compress_factor_",      (DL_FUNC) &_blosc_blosc_compress_factor_,       6},
+    {"_blosc_blosc_compress_file_",        (DL_FUNC) &_blosc_blosc_compress_file_,         8},
+    {"_blosc_blosc_connection_",           (DL_FUNC) &_blosc_blosc_connection_,            8},
+    {"_blosc_blosc_decompress_async_",     (DL_FUNC) &_blosc_blosc_decompress_async_,      2},
+    {"_blosc_blosc_decompress_dat",        (DL_FUNC) &_blosc_blosc_decompress_dat,         2},
+    {"_blosc_blosc_decompress_file_",      (DL_FUNC) &_blosc_blosc_decompress_file_,       3},
+    {"_blosc_blosc_decompress_integer64_", (DL_FUNC) &_blosc_blosc_decompress_integer64_,  4},
+    {"_blosc_blosc_decompress_native_",    (DL_FUNC) &_blosc_blosc_decompress_native_,     4},
+    {"_blosc_blosc_decompress_region_",    (DL_FUNC) &_blosc_blosc_decompress_region_,     8},
+    {"_blosc_blosc_filter_dat",            (DL_FUNC) &_blosc_blosc_filter_dat,             6},
+    {"_blosc_blosc_info_",                 (DL_FUNC) &_blosc_blosc_info_,                  1},
+    {"_blosc_blosc_read_file_",            (DL_FUNC) &_blosc_blosc_read_file_,             4},
+    {"_blosc_blosc_recompress_",           (DL_FUNC) &_blosc_blosc_recompress_,            6},
+    {"_blosc_blosc_recompress_file_",      (DL_FUNC) &_blosc_blosc_recompress_file_,       8},
+    {"_blosc_blosc_reduce_",               (DL_FUNC) &_blosc_blosc_reduce_,                6},
+    {"_blosc_blosc_self_test_",            (DL_FUNC) &_blosc_blosc_self_test_,             3},
+    {"_blosc_blosc_serialize_",            (DL_FUNC) &_blosc_blosc_serialize_,            10},
+    {"_blosc_blosc_train_dict_",           (DL_FUNC) &_blosc_blosc_train_dict_,            2},
+    {"_blosc_blosc_unserialize_",          (DL_FUNC) &_blosc_blosc_unserialize_,           4},
+    {"_blosc_blosc_which_",                (DL_FUNC) &_blosc_blosc_which_,                 8},
+    {"_blosc_check_dt_units",              (DL_FUNC) &_blosc_check_dt_units,               0},
+    {"_blosc_dtype_convert_",              (DL_FUNC) &_blosc_dtype_convert_,               5},
+    {"_blosc_dtype_is_native_",            (DL_FUNC) &_blosc_dtype_is_native_,             3},
+    {"_blosc_dtype_to_integer64_",         (DL_FUNC) &_blosc_dtype_to_integer64_,          3},
+    {"_blosc_dtype_to_list_",              (DL_FUNC) &_blosc_dtype_to_list_,               1},
+    {"_blosc_dtype_to_r_",                 (DL_FUNC) &_blosc_dtype_to_r_,                  3},
+    {"_blosc_integer64_to_dtype_",         (DL_FUNC) &_blosc_integer64_to_dtype_,          3},
+    {"_blosc_r_to_dtype_",                 (DL_FUNC) &_blosc_r_to_dtype_,                  3},
+    {"_blosc_zarr_read_chunks_",           (DL_FUNC) &_blosc_zarr_read_chunks_,           10},
+    {"_blosc_zarr_read_shards_",           (DL_FUNC) &_blosc_zarr_read_shards_,           12},
+    {"_blosc_zarr_write_chunks_",          (DL_FUNC) &_blosc_zarr_write_chunks_,          15},
+    {"_blosc_zarr_write_shards_",          (DL_FUNC) &_blosc_zarr_write_shards_,          15},
     {NULL, NULL, 0}
 };
 }
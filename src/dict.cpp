@@ -0,0 +1,208 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "dict.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+
+// Loading a dictionary takes much longer than compressing a small record
+// with it. The digested dictionary (and the context using it) is therefore
+// kept for subsequent calls, as records are typically compressed one by one
+// with the same dictionary. Each thread has its own cache, such that
+// threads never wait for each other. A cache is freed when its thread ends.
+struct compress_cache {
+  std::vector<uint8_t> dict;
+  int level = 0;
+  ZSTD_CDict *cdict = nullptr;
+  ZSTD_CCtx *cctx = nullptr;
+
+  void release() {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeCCtx(cctx);
+    cdict = nullptr;
+    cctx = nullptr;
+    dict.clear();
+  }
+  ~compress_cache() { release(); }
+};
+
+struct decompress_cache {
+  std::vector<uint8_t> dict;
+  ZSTD_DDict *ddict = nullptr;
+  ZSTD_DCtx *dctx = nullptr;
+
+  void release() {
+    ZSTD_freeDDict(ddict);
+    ZSTD_freeDCtx(dctx);
+    ddict = nullptr;
+    dctx = nullptr;
+    dict.clear();
+  }
+  ~decompress_cache() { release(); }
+};
+
+static thread_local compress_cache ccache;
+static thread_local decompress_cache dcache;
+
+static bool same_dict(const std::vector<uint8_t> &cached, const uint8_t *dict,
+                      size_t dict_size) {
+  return cached.size() == dict_size && memcmp(cached.data(), dict, dict_size) == 0;
+}
+
+// Same mapping of compression levels as blosc uses for its zstd codec
+static int zstd_level(int level) {
+  if (level < 1) level = 1;
+  return level < 9 ? level * 2 - 1 : ZSTD_maxCLevel();
+}
+
+bool dict_available() {
+  return true;
+}
+
+void dict_release() {
+  ccache.release();
+  dcache.release();
+}
+
+std::vector<uint8_t> dict_train(const std::vector<uint8_t> &samples,
+                                const std::vector<size_t> &sizes, size_t capacity) {
+  std::vector<uint8_t> result(capacity);
+  size_t out = ZDICT_trainFromBuffer(result.data(), capacity, samples.data(),
+                                     sizes.data(), (unsigned)sizes.size());
+  if (ZDICT_isError(out))
+    throw std::runtime_error(std::string("Failed to train dictionary: ") +
+                             ZDICT_getErrorName(out));
+  result.resize(out);
+  return result;
+}
+
+uint32_t dict_id(const uint8_t *dict, size_t dict_size) {
+  return ZDICT_getDictID(dict, dict_size);
+}
+#else
+bool dict_available() {
+  return false;
+}
+
+void dict_release() {}
+
+static void dict_unavailable() {
+  throw std::runtime_error("Package was built without zstd dictionary support");
+}
+
+std::vector<uint8_t> dict_train(const std::vector<uint8_t> &samples,
+                                const std::vector<size_t> &sizes, size_t capacity) {
+  dict_unavailable();
+  return std::vector<uint8_t>();
+}
+
+uint32_t dict_id(const uint8_t *dict, size_t dict_size) {
+  dict_unavailable();
+  return 0;
+}
+#endif
+
+// Byte shuffle, as applied by blosc: the i-th byte of all elements is
+// stored contiguously. Trailing bytes that do not form an element are copied.
+static void byte_shuffle(const uint8_t *src, uint8_t *dest, size_t size,
+                         size_t typesize, bool inverse) {
+  size_t n = size / typesize;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < typesize; j++) {
+      if (inverse)
+        dest[i * typesize + j] = src[j * n + i];
+      else
+        dest[j * n + i] = src[i * typesize + j];
+    }
+  }
+  memcpy(dest + n * typesize, src + n * typesize, size - n * typesize);
+}
+
+ext_section dict_compress(const uint8_t *src, size_t size, int level, int typesize,
+                          bool doshuffle, const uint8_t *dict, size_t dict_size,
+                          std::vector<uint8_t> &dest) {
+  ext_section s;
+  s.id = EXT_DICT;
+  s.payload.assign(DICT_SECTION_SIZE, 0);
+  doshuffle = doshuffle && typesize > 1;
+  put_u32_le(s.payload.data(), dict_id(dict, dict_size));
+  s.payload[4] = (uint8_t)typesize;
+  s.payload[5] = doshuffle ? 1 : 0;
+  put_u64_le(s.payload.data() + 8, (uint64_t)size);
+
+  std::vector<uint8_t> shuffled;
+  if (doshuffle) {
+    shuffled.resize(size);
+    byte_shuffle(src, shuffled.data(), size, (size_t)typesize, false);
+    src = shuffled.data();
+  }
+#ifdef HAVE_ZSTD
+  if (ccache.cdict == nullptr || ccache.level != level ||
+      !same_dict(ccache.dict, dict, dict_size)) {
+    ZSTD_freeCDict(ccache.cdict);
+    ccache.dict.assign(dict, dict + dict_size);
+    ccache.level = level;
+    ccache.cdict = ZSTD_createCDict(dict, dict_size, zstd_level(level));
+    if (ccache.cdict == nullptr) {
+      ccache.dict.clear();
+      throw std::runtime_error("Failed to load dictionary");
+    }
+  }
+  if (ccache.cctx == nullptr) ccache.cctx = ZSTD_createCCtx();
+  if (ccache.cctx == nullptr) throw std::runtime_error("Failed to create zstd context");
+  // The section already records the size and dictionary, so the frame
+  // header can omit them
+  ZSTD_CCtx_reset(ccache.cctx, ZSTD_reset_session_and_parameters);
+  ZSTD_CCtx_setParameter(ccache.cctx, ZSTD_c_contentSizeFlag, 0);
+  ZSTD_CCtx_setParameter(ccache.cctx, ZSTD_c_dictIDFlag, 0);
+  ZSTD_CCtx_refCDict(ccache.cctx, ccache.cdict);
+  dest.resize(ZSTD_compressBound(size));
+  size_t out = ZSTD_compress2(ccache.cctx, dest.data(), dest.size(), src, size);
+  if (ZSTD_isError(out))
+    throw std::runtime_error(std::string("zstd compressor failed: ") +
+                             ZSTD_getErrorName(out));
+  dest.resize(out);
+#endif
+  return s;
+}
+
+size_t dict_nbytes(const ext_section &section) {
+  if (section.id != EXT_DICT || section.payload.size() != DICT_SECTION_SIZE)
+    throw std::runtime_error("Corrupt dictionary section in extension header");
+  return (size_t)get_u64_le(section.payload.data() + 8);
+}
+
+void dict_decompress(const ext_section &section, const uint8_t *src, size_t size,
+                     const uint8_t *dict, size_t dict_size, uint8_t *dest) {
+  size_t nbytes = dict_nbytes(section);
+  if (dict_size == 0)
+    throw std::runtime_error("Data was compressed with a dictionary, which should be provided");
+  if (get_u32_le(section.payload.data()) != dict_id(dict, dict_size))
+    throw std::runtime_error("Data was compressed with a different dictionary");
+  size_t typesize = section.payload[4];
+  bool doshuffle = section.payload[5] != 0 && typesize > 1;
+  std::vector<uint8_t> shuffled(doshuffle ? nbytes : 0);
+#ifdef HAVE_ZSTD
+  {
+    uint8_t *out = doshuffle ? shuffled.data() : dest;
+    if (dcache.ddict == nullptr || !same_dict(dcache.dict, dict, dict_size)) {
+      ZSTD_freeDDict(dcache.ddict);
+      dcache.dict.assign(dict, dict + dict_size);
+      dcache.ddict = ZSTD_createDDict(dict, dict_size);
+      if (dcache.ddict == nullptr) {
+        dcache.dict.clear();
+        throw std::runtime_error("Failed to load dictionary");
+      }
+    }
+    if (dcache.dctx == nullptr) dcache.dctx = ZSTD_createDCtx();
+    if (dcache.dctx == nullptr) throw std::runtime_error("Failed to create zstd context");
+    size_t result = ZSTD_decompress_usingDDict(dcache.dctx, out, nbytes, src, size,
+                                               dcache.ddict);
+    if (ZSTD_isError(result) || result != nbytes)
+      throw std::runtime_error("Failed to decompress data");
+  }
+#endif
+  if (doshuffle) byte_shuffle(shuffled.data(), dest, nbytes, typesize, true);
+}
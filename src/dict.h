@@ -0,0 +1,44 @@
+#ifndef BLOSC_DICT_H
+#define BLOSC_DICT_H
+
+#include <cstdint>
+#include <vector>
+#include "header.h"
+
+// Compression of small buffers with a trained zstd dictionary. Blosc1 offers
+// no way to pass an external dictionary to its codecs, so data compressed
+// with a dictionary is stored as a single zstd frame, preceded by an
+// extension header with an `EXT_DICT` section. The section payload consists
+// of the dictionary id (uint32 LE), the type size (1 byte), whether bytes
+// were shuffled (1 byte), 2 reserved bytes and the uncompressed size
+// (uint64 LE).
+//
+// The functions below require the package to be built with libzstd
+// (`HAVE_ZSTD`), and throw a `std::runtime_error` otherwise.
+
+#define DICT_SECTION_SIZE 16
+
+// Is dictionary compression available?
+bool dict_available();
+// Frees the dictionaries and contexts cached by the calling thread
+void dict_release();
+// Trains a dictionary of at most `capacity` bytes on `samples`, which are
+// stored back to back, with `sizes` the sizes of the individual samples
+std::vector<uint8_t> dict_train(const std::vector<uint8_t> &samples,
+                                const std::vector<size_t> &sizes, size_t capacity);
+// Identifier of a dictionary, recorded with the compressed data
+uint32_t dict_id(const uint8_t *dict, size_t dict_size);
+// Compresses `src` with the dictionary. `level` is a blosc compression
+// level (1-9). Bytes are shuffled first when `doshuffle` is set and
+// `typesize` > 1. Returns the `EXT_DICT` section describing the result.
+ext_section dict_compress(const uint8_t *src, size_t size, int level, int typesize,
+                          bool doshuffle, const uint8_t *dict, size_t dict_size,
+                          std::vector<uint8_t> &dest);
+// Uncompressed size of data described by an `EXT_DICT` section
+size_t dict_nbytes(const ext_section &section);
+// Decompresses `src`, described by `section`, into `dest`, which should be
+// `dict_nbytes(section)` long
+void dict_decompress(const ext_section &section, const uint8_t *src, size_t size,
+                     const uint8_t *dict, size_t dict_size, uint8_t *dest);
+
+#endif /* BLOSC_DICT_H */
@@ -1,9 +1,9 @@
 #include <cpp11.hpp>
+#include <cmath>
+#include <cstdint>
 #include <regex>
 #include "umHalf.h"
-#include "blosc.h"
-
-using namespace cpp11;
+#include "dtype.h"
 
 // Careful : days_in_year is for base-0 years, days_in_month for base-1970.
 #define isleap(y) ((((y) % 4) == 0 && ((y) % 100) != 0) || ((y) % 400) == 0)
@@ -30,48 +30,6 @@ static const char *difftime_units_cor[] = {
   "W", "D", "h", "m", "s"
 };
 
-typedef struct {
-  bool needs_byteswap;
-  char main_type;
-  uint8_t byte_size;
-  std::string unit;
-  double unit_conversion;
-} blosc_dtype;
-
-typedef struct {
-  float real;
-  float imaginary;
-} complex32;
-
-typedef struct {
-  double real;
-  double imaginary;
-} complex64;
-
-union conversion_t {
-  int8_t    b1;
-  uint8_t   u1;
-  int8_t    i1;
-  uint16_t  u2;
-  int16_t   i2;
-  uint32_t  u4;
-  int32_t   i4;
-  uint64_t  u8;
-  int64_t   i8;
-  uint16_t  f2; // bit representation obtained from float16
-  float     f4;
-  double    f8;
-  complex32 c8;
-  complex64 c16;
-  char      S[BLOSC_MAX_TYPESIZE];
-};
-
-bool convert_data(uint8_t *input, SEXP input_sexp, int rtype, int n, blosc_dtype dtype,
-                  uint8_t *output, sexp na_value);
-bool convert_data_inv(conversion_t *input, blosc_dtype dtype,
-                      int rtype, uint8_t *output, sexp na_value);
-void byte_swap(uint8_t * data, blosc_dtype dtype, uint32_t n);
-
 void getYM(double d, int64_t &mon, int64_t &Y) {
   bool valid = R_FINITE(d) != 0;
   int64_t y = 1970, tmp;
@@ -205,6 +163,17 @@ list dtype_to_list_(std::string dtype) {
   return result;
 }
 
+double float16_to_double(uint16_t bits) {
+  float16 f = 0.0;
+  memcpy((uint16_t *)&f, &bits, sizeof(float16));
+  return double(f);
+}
+
+uint16_t double_to_float16(double d) {
+  float16 f = d;
+  return f.GetBits();
+}
+
 int64_t numdays(int64_t y, int64_t m, int64_t d) {
   m = (m + 9) % 12;
   y = y - m/10;
@@ -251,6 +220,43 @@ sexp check_na(sexp na_value, int rtype) {
   }
 }
 
+blosc_na resolve_na(sexp na_value, int rtype) {
+  blosc_na na;
+  sexp new_na_value = check_na(na_value, rtype);
+  na.ignore = Rf_isNull(new_na_value);
+  na.int_value = NA_INTEGER;
+  na.real_value = NA_REAL;
+  if (!na.ignore) {
+    if (TYPEOF(new_na_value) == INTSXP) {
+      na.int_value = INTEGER(new_na_value)[0];
+    } else if (TYPEOF(new_na_value) == REALSXP) {
+      na.real_value = REAL(new_na_value)[0];
+    }
+  }
+  return na;
+}
+
+// R type used to represent a dtype in memory. Note that complex numbers are
+// decoded as pairs of REALs by `convert_data_inv()`.
+int dtype_rtype(const blosc_dtype &dt) {
+  if (dt.main_type == 'b' && dt.byte_size == 1) return LGLSXP;
+  if (dt.main_type == 'i' && dt.byte_size <= 4) return INTSXP;
+  if (dt.main_type == 'i' && dt.byte_size <= 8) return REALSXP;
+  if (dt.main_type == 'u' && dt.byte_size <= 3) return INTSXP;
+  if (dt.main_type == 'u' && dt.byte_size <= 7) return REALSXP;
+  if ((dt.main_type == 'f' || dt.main_type == 'M' || dt.main_type == 'm') &&
+      dt.byte_size <= 8) return REALSXP;
+  if (dt.main_type == 'c' && dt.byte_size <= 16) return CPLXSXP;
+  if (dt.main_type == 'S' || dt.main_type == 'U') return STRSXP;
+  stop("Cannot convert data type to an R type");
+}
+
+// Number of bytes occupied by a single element of `dt`
+int dtype_item_size(const blosc_dtype &dt) {
+  if (dt.main_type == 'U') return 4 * (int)dt.byte_size;
+  return (int)dt.byte_size;
+}
+
 [[cpp11::register]]
 sexp dtype_to_r_(raws data, std::string dtype, sexp na_value) {
   blosc_dtype dt = prepare_dtype(dtype);
@@ -262,7 +268,6 @@ sexp dtype_to_r_(raws data, std::string dtype, sexp na_value) {
   cempty.imaginary = 0.0;
   empty.c16 = cempty;
   conv = empty;
-  int64_t bigint = 0;
   int n = data.size() / dt.byte_size, mult_factor = 1;
   uint8_t *src;
   if (dt.needs_byteswap) {
@@ -360,12 +365,12 @@ sexp dtype_to_r_(raws data, std::string dtype, sexp na_value) {
   }
   
   bool warn = false;
-  sexp new_na_value = check_na(na_value, TYPEOF(result));
+  blosc_na na = resolve_na(na_value, TYPEOF(result));
   for (int i = 0; i < mult_factor * n; i++) {
     conv = empty;
     memcpy(&conv, src + i * dt.byte_size / mult_factor, dt.byte_size / mult_factor);
     bool should_warn =
-      convert_data_inv(&conv, dt, TYPEOF(result), dest + i*out_size, new_na_value);
+      convert_data_inv(&conv, dt, TYPEOF(result), dest + i*out_size, na);
     if (should_warn) warn = true;
   }
   
@@ -378,12 +383,19 @@ sexp dtype_to_r_(raws data, std::string dtype, sexp na_value) {
     UNPROTECT(1); // c
     return c;
   }
+  convert_time_units(result, dt, n);
+  if (warn) warning("Data contains values equal to R's NA representation");
+  return result;
+}
+
+void convert_time_units(sexp result, const blosc_dtype &dt, R_xlen_t n) {
+  int64_t bigint = 0;
   if (dt.main_type == 'M') {
     result.attr("class") = writable::strings({"POSIXct", "POSIXt"});
     result.attr("tzone") = writable::strings((r_string)"UTC");
     double *d = REAL(result);
     
-    for (int j = 0; j < n; j++) {
+    for (R_xlen_t j = 0; j < n; j++) {
       memcpy(&bigint, (int64_t *)(&(d[j])), sizeof(double));
       if (dt.unit_conversion > 0) {
         d[j] = ((double)bigint)*dt.unit_conversion;
@@ -438,25 +450,23 @@ sexp dtype_to_r_(raws data, std::string dtype, sexp na_value) {
     
     double *d = REAL(result);
     
-    for (int j = 0; j < n; j++) {
+    for (R_xlen_t j = 0; j < n; j++) {
       memcpy(&bigint, (int64_t *)(&(d[j])), sizeof(double));
       if (!R_IsNA(d[j])) d[j] = ((double)bigint) * unt_conv;
     }
   }
-  if (warn) warning("Data contains values equal to R's NA representation");
-  return result;
 }
 
-bool convert_data_inv(conversion_t *input, blosc_dtype dtype,
-                      int rtype, uint8_t *output, sexp na_value) {
-  bool ignore_na = Rf_isNull(na_value), warn_na = false;
+bool convert_data_inv(conversion_t *input, const blosc_dtype &dtype,
+                      int rtype, uint8_t *output, const blosc_na &na) {
+  bool ignore_na = na.ignore, warn_na = false;
   
   if (rtype == LGLSXP) {
     if (dtype.main_type == 'b' && dtype.byte_size == 1) {
       int b = (int)((int8_t)(*input).b1);
       if (!ignore_na) {
-        int nval = INTEGER(na_value)[0];
-        if (b == NA_INTEGER && !ISNA(na_value)) warn_na = true;
+        int nval = na.int_value;
+        if (b == NA_INTEGER && nval != NA_INTEGER) warn_na = true;
         if (b == nval) b = NA_LOGICAL;
       }
       memcpy(output, &b, sizeof(int));
@@ -478,7 +488,7 @@ bool convert_data_inv(conversion_t *input, blosc_dtype dtype,
     } else stop("Conversion not implemented");
     
     if (!ignore_na) {
-      int nval = INTEGER(na_value)[0];
+      int nval = na.int_value;
       if (i == NA_INTEGER && nval != NA_INTEGER) warn_na = true;
       if (i == nval) i = NA_INTEGER;
     }
@@ -507,7 +517,7 @@ bool convert_data_inv(conversion_t *input, blosc_dtype dtype,
     } else  stop("Conversion not implemented");
     
     if (!ignore_na) {
-      double nval = REAL(na_value)[0];
+      double nval = na.real_value;
       if (dtype.main_type == 'M' || dtype.main_type == 'm') {
         int64_t na_cor;
         memcpy(&na_cor, (int64_t *)(&NA_REAL), sizeof(double));
@@ -731,6 +741,164 @@ bool convert_data(uint8_t *input, SEXP input_data, int rtype, int n,
   return warn_na;
 }
 
+// Whether `data` is stored in memory exactly as `dtype` would encode it, such
+// that it can be compressed without conversion: little-endian 32 bit integers,
+// 64 bit doubles and 128 bit complex numbers on little-endian hosts, and
+// `integer64` vectors as little-endian 64 bit integers. Missing values need
+// to be encoded as is.
+[[cpp11::register]]
+bool dtype_is_native_(SEXP data, std::string dtype, sexp na_value) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  int rtype = dtype_native_rtype(dt);
+  // `integer64` vectors hold signed 64 bit integers in a double vector
+  if (Rf_inherits(data, "integer64")) {
+    if (TYPEOF(data) != REALSXP || dt.main_type != 'i' || dt.byte_size != 8 ||
+        dt.needs_byteswap)
+      return false;
+    return !resolve_integer64_na(na_value).map;
+  }
+  if (rtype == NILSXP || TYPEOF(data) != rtype) return false;
+  blosc_na na = resolve_na(na_value, rtype);
+  return na.ignore || (rtype == INTSXP && na.int_value == NA_INTEGER);
+}
+
+int dtype_native_rtype(const blosc_dtype &dt) {
+  if (dt.needs_byteswap) return NILSXP;
+  if (dt.main_type == 'i' && dt.byte_size == 4) return INTSXP;
+  if (dt.main_type == 'f' && dt.byte_size == 8) return REALSXP;
+  if (dt.main_type == 'c' && dt.byte_size == 16) return CPLXSXP;
+  return NILSXP;
+}
+
+bool native_na_inverse(SEXP result, const blosc_na &na) {
+  if (na.ignore) return false;
+  bool warn = false;
+  if (TYPEOF(result) == INTSXP) {
+    int *d = INTEGER(result);
+    for (R_xlen_t i = 0; i < Rf_xlength(result); i++) {
+      if (d[i] == NA_INTEGER && na.int_value != NA_INTEGER) warn = true;
+      if (d[i] == na.int_value) d[i] = NA_INTEGER;
+    }
+  } else {
+    // Real and imaginary components of complex numbers are remapped
+    // individually, like in `dtype_to_r_()`
+    double *d = TYPEOF(result) == CPLXSXP ? (double *)COMPLEX(result) : REAL(result);
+    R_xlen_t n = Rf_xlength(result) * (TYPEOF(result) == CPLXSXP ? 2 : 1);
+    bool na_is_na = R_IsNA(na.real_value);
+    for (R_xlen_t i = 0; i < n; i++) {
+      if (R_IsNA(d[i]) && !na_is_na) warn = true;
+      if (d[i] == na.real_value) d[i] = NA_REAL;
+    }
+  }
+  return warn;
+}
+
+static inline uint64_t swap_u64(uint64_t v) {
+  uint64_t result = 0;
+  for (int i = 0; i < 8; i++) result = (result << 8) | ((v >> (8 * i)) & 0xff);
+  return result;
+}
+
+void check_integer64(const blosc_dtype &dt) {
+  if ((dt.main_type != 'i' && dt.main_type != 'u') || dt.byte_size != 8)
+    stop("`integer64` requires an 8 byte integer `dtype` ('i8' or 'u8')");
+}
+
+// `NA` of `integer64` is the smallest 64 bit integer
+#define INTEGER64_NA INT64_MIN
+
+integer64_na resolve_integer64_na(sexp na_value) {
+  integer64_na result = {false, INTEGER64_NA};
+  // The bits of `integer64` values are read as is, such that they stay exact
+  if (Rf_inherits(na_value, "integer64") && TYPEOF(na_value) == REALSXP &&
+      Rf_xlength(na_value) > 0) {
+    memcpy(&result.value, REAL(na_value), sizeof(int64_t));
+    result.map = result.value != INTEGER64_NA;
+    return result;
+  }
+  blosc_na na = resolve_na(na_value, REALSXP);
+  if (na.ignore || ISNAN(na.real_value)) return result;
+  double limit = std::ldexp(1.0, 63);
+  if (!(na.real_value >= -limit && na.real_value < limit))
+    stop("`na_value` is out of the range of 64 bit integers");
+  result.map = true;
+  result.value = (int64_t)na.real_value;
+  return result;
+}
+
+void integer64_decode(uint8_t *data, size_t n, const blosc_dtype &dt,
+                      const integer64_na &na) {
+  bool map_na = na.map;
+  int64_t na_int = na.value;
+  bool swap = dt.needs_byteswap, is_unsigned = dt.main_type == 'u';
+  bool out_of_range = false;
+  // Byte order, range and missing values are handled in a single pass
+  for (size_t i = 0; i < n; i++) {
+    uint64_t u;
+    memcpy(&u, data + 8 * i, 8);
+    if (swap) u = swap_u64(u);
+    int64_t v = (int64_t)u;
+    if (is_unsigned && v < 0) out_of_range = true;
+    if (map_na && v == na_int) v = INTEGER64_NA;
+    memcpy(data + 8 * i, &v, 8);
+  }
+  if (out_of_range) stop("Unsigned values exceed the range of `integer64`");
+}
+
+void set_integer64_class(SEXP result) {
+  SEXP cls = PROTECT(Rf_mkString("integer64"));
+  Rf_setAttrib(result, R_ClassSymbol, cls);
+  UNPROTECT(1);
+}
+
+// Decodes 64 bit integers as an `integer64` vector (see the bit64
+// package), which stores their bits in a double vector
+[[cpp11::register]]
+SEXP dtype_to_integer64_(raws data, std::string dtype, sexp na_value) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  check_integer64(dt);
+  if (data.size() % 8 != 0)
+    stop("Raw data size needs to be multitude of data type size");
+  integer64_na na = resolve_integer64_na(na_value);
+  R_xlen_t n = data.size() / 8;
+  sexp result = safe[Rf_allocVector](REALSXP, n);
+  uint8_t *dest = (uint8_t *)REAL(result);
+  if (n > 0) memcpy(dest, RAW(as_sexp(data)), (size_t)n * 8);
+  integer64_decode(dest, (size_t)n, dt, na);
+  set_integer64_class(result);
+  return result;
+}
+
+// Encodes an `integer64` vector as 64 bit integers, without converting
+// its values to doubles
+[[cpp11::register]]
+raws integer64_to_dtype_(doubles data, std::string dtype, sexp na_value) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  check_integer64(dt);
+  integer64_na na = resolve_integer64_na(na_value);
+  bool map_na = na.map;
+  int64_t na_int = na.value;
+  bool swap = dt.needs_byteswap, is_unsigned = dt.main_type == 'u';
+  R_xlen_t n = data.size();
+  writable::raws result(n * 8);
+  const uint8_t *src = (const uint8_t *)REAL(as_sexp(data));
+  uint8_t *dest = (uint8_t *)RAW(as_sexp(result));
+  bool warn_na = false, out_of_range = false;
+  for (R_xlen_t i = 0; i < n; i++) {
+    int64_t v;
+    memcpy(&v, src + 8 * i, 8);
+    if (map_na && v == na_int) warn_na = true;
+    if (map_na && v == INTEGER64_NA) v = na_int;
+    if (is_unsigned && v < 0) out_of_range = true;
+    uint64_t u = (uint64_t)v;
+    if (swap) u = swap_u64(u);
+    memcpy(dest + 8 * i, &u, 8);
+  }
+  if (out_of_range) stop("Negative values cannot be encoded as unsigned integers");
+  if (warn_na) warning("Data contains values equal to the value representing missing values!");
+  return result;
+}
+
 [[cpp11::register]]
 raws r_to_dtype_(sexp data, std::string dtype, sexp na_value) {
   blosc_dtype dt = prepare_dtype(dtype);
@@ -0,0 +1,96 @@
+#ifndef BLOSC_DTYPE_H
+#define BLOSC_DTYPE_H
+
+#include <cpp11.hpp>
+#include "backend.h"
+
+using namespace cpp11;
+
+typedef struct {
+  bool needs_byteswap;
+  char main_type;
+  uint8_t byte_size;
+  std::string unit;
+  double unit_conversion;
+} blosc_dtype;
+
+typedef struct {
+  float real;
+  float imaginary;
+} complex32;
+
+typedef struct {
+  double real;
+  double imaginary;
+} complex64;
+
+union conversion_t {
+  int8_t    b1;
+  uint8_t   u1;
+  int8_t    i1;
+  uint16_t  u2;
+  int16_t   i2;
+  uint32_t  u4;
+  int32_t   i4;
+  uint64_t  u8;
+  int64_t   i8;
+  uint16_t  f2; // bit representation obtained from float16
+  float     f4;
+  double    f8;
+  complex32 c8;
+  complex64 c16;
+  char      S[BLOSC_MAX_TYPESIZE];
+};
+
+// Value representing missing values, resolved on the main thread such that
+// it can be used by conversion kernels without touching the R API.
+typedef struct {
+  bool ignore;
+  int int_value;
+  double real_value;
+} blosc_na;
+
+blosc_dtype prepare_dtype(std::string dtype);
+int dtype_rtype(const blosc_dtype &dtype);
+int dtype_item_size(const blosc_dtype &dtype);
+// R type that stores `dtype` in memory exactly as it is encoded (`INTSXP`,
+// `REALSXP` or `CPLXSXP`), or `NILSXP` when it needs conversion
+int dtype_native_rtype(const blosc_dtype &dtype);
+// Replaces values equal to `na` by R's `NA` in a vector decoded from a native
+// dtype. Returns `true` when it already contained `NA` values.
+bool native_na_inverse(SEXP result, const blosc_na &na);
+sexp check_na(sexp na_value, int rtype);
+blosc_na resolve_na(sexp na_value, int rtype);
+bool convert_data(uint8_t *input, SEXP input_sexp, int rtype, int n, blosc_dtype dtype,
+                  uint8_t *output, sexp na_value);
+bool convert_data_inv(conversion_t *input, const blosc_dtype &dtype,
+                      int rtype, uint8_t *output, const blosc_na &na);
+sexp dtype_to_r_(raws data, std::string dtype, sexp na_value);
+void convert_time_units(sexp result, const blosc_dtype &dtype, R_xlen_t n);
+void byte_swap(uint8_t * data, blosc_dtype dtype, uint32_t n);
+// Value of the half precision float with bit representation `bits`. Does not
+// use the R API.
+double float16_to_double(uint16_t bits);
+// Bit representation of `d` as a half precision float
+uint16_t double_to_float16(double d);
+// Stops unless `dtype` is a 64 bit integer, which can be represented by
+// bit64's `integer64` class
+void check_integer64(const blosc_dtype &dtype);
+// Value representing missing values of 64 bit integers. `map` is false when
+// missing values are stored as `NA` (the smallest 64 bit integer).
+typedef struct {
+  bool map;
+  int64_t value;
+} integer64_na;
+// Resolves `na_value` (a number or an `integer64` value) for 64 bit integers.
+// Stops when a number is out of their range.
+integer64_na resolve_integer64_na(sexp na_value);
+// Converts `n` elements of (64 bit integer) `dtype` at `data` in place to
+// `integer64` values: signed and in the host's byte order. Values equal to
+// `na` become `NA`.
+void integer64_decode(uint8_t *data, size_t n, const blosc_dtype &dtype,
+                      const integer64_na &na);
+// Sets the class of `result` to `integer64`
+void set_integer64_class(SEXP result);
+
+#endif /* BLOSC_DTYPE_H */
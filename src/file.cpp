@@ -0,0 +1,220 @@
+#include <cpp11.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "backend.h"
+#include "container.h"
+#include "mapped.h"
+#include "parallel.h"
+
+using namespace cpp11;
+
+// Input is read and output is written on the main thread, while workers
+// (de)compress chunks in the mean time. Only a few chunks are held in
+// memory at any time, whatever the size of the file. The output file is
+// removed when an error occurs after it was created. Compressed files are
+// memory mapped, such that chunks are decompressed without copying them.
+
+[[cpp11::register]]
+double blosc_compress_file_(std::string input, std::string output,
+                            std::string compressor, int level, int doshuffle,
+                            int typesize, double chunk_size, int nthreads) {
+  uint64_t written = 0;
+  bool created = false;
+  try {
+    container_file in(input, false);
+    container_file out(output, true);
+    created = true;
+    container_sink sink = out.sink();
+    container_writer writer([&sink, &written](const uint8_t *p, size_t n) {
+      sink(p, n);
+      written += n;
+    }, compressor, level, doshuffle, typesize, (size_t)chunk_size, nthreads);
+    container_source source = in.source();
+    std::vector<uint8_t> buffer((size_t)chunk_size);
+    size_t n;
+    while ((n = source(buffer.data(), buffer.size())) > 0) {
+      writer.write(buffer.data(), n);
+      check_user_interrupt();
+    }
+    writer.finish();
+    out.close();
+  } catch (...) {
+    if (created) std::remove(output.c_str());
+    throw;
+  }
+  return (double)written;
+}
+
+// Validates chunk `i` of a mapped container in place and decompresses it
+// straight from the mapped pages into `dest`. Can be called by workers.
+static void decompress_mapped_chunk(const mapped_file &map, const container_index &index,
+                                    size_t i, uint8_t *dest) {
+  const uint8_t *src = map.data() + index.entries[i].offset;
+  size_t cbytes = (size_t)index.entries[i].cbytes;
+  size_t expected = container_chunk_nbytes(index, i);
+  size_t nbytes = 0, header_nbytes = 0, header_cbytes = 0, blocksize = 0;
+  if (backend_cbuffer_validate(src, cbytes, &nbytes) < 0)
+    throw std::runtime_error("Corrupt chunk in container");
+  backend_cbuffer_sizes(src, &header_nbytes, &header_cbytes, &blocksize);
+  if (nbytes != expected || header_cbytes != cbytes)
+    throw std::runtime_error("Corrupt chunk in container");
+  int out = backend_decompress(src, cbytes, dest, nbytes, 1);
+  if (out < 0 || (size_t)out != nbytes)
+    throw std::runtime_error("Failed to decompress data");
+}
+
+// The sequential reader stops at the index, so the footer is checked
+// separately to detect truncated files
+static void check_footer(const std::string &input, uint64_t nbytes) {
+  FILE *f = std::fopen(input.c_str(), "rb");
+  uint8_t footer[BLXC_FOOTER_SIZE];
+  bool complete = f != nullptr && std::fseek(f, -BLXC_FOOTER_SIZE, SEEK_END) == 0 &&
+    std::fread(footer, 1, BLXC_FOOTER_SIZE, f) == BLXC_FOOTER_SIZE;
+  if (f != nullptr) std::fclose(f);
+  if (!complete || container_parse_footer(footer).nbytes != nbytes)
+    throw std::runtime_error("Blosc container is incomplete or corrupt");
+}
+
+#ifndef _WIN32
+// Decompresses batches of chunks in parallel, straight from the mapped file,
+// and writes them in order
+static uint64_t decompress_file(const std::string &input, container_file &out,
+                                int nthreads) {
+  mapped_file map(input);
+  container_index index = container_parse_index(map.data(), map.size());
+  map.advise(0, map.size(), mapped_file::ACCESS_SEQUENTIAL);
+  container_sink sink = out.sink();
+  size_t nchunks = index.entries.size();
+  size_t batch = 2 * (size_t)std::max(nthreads, 1);
+  std::vector<std::vector<uint8_t>> buffers(batch);
+  for (size_t first = 0; first < nchunks; first += batch) {
+    size_t n = std::min(batch, nchunks - first);
+    parallel_for(n, nthreads, [&](size_t j) {
+      buffers[j].resize(container_chunk_nbytes(index, first + j));
+      decompress_mapped_chunk(map, index, first + j, buffers[j].data());
+    });
+    for (size_t j = 0; j < n; j++) sink(buffers[j].data(), buffers[j].size());
+    check_user_interrupt();
+  }
+  return index.footer.nbytes;
+}
+#else
+// Without memory maps, chunks are streamed through a `container_reader`,
+// such that memory use remains bounded
+static uint64_t decompress_file(const std::string &input, container_file &out,
+                                int nthreads) {
+  uint64_t written = 0;
+  container_file in(input, false);
+  container_sink sink = out.sink();
+  container_reader reader(in.source(), nthreads);
+  std::vector<uint8_t> buffer(1 << 20);
+  size_t n;
+  while ((n = reader.read(buffer.data(), buffer.size())) > 0) {
+    sink(buffer.data(), n);
+    written += n;
+    check_user_interrupt();
+  }
+  check_footer(input, written);
+  return written;
+}
+#endif
+
+[[cpp11::register]]
+double blosc_decompress_file_(std::string input, std::string output, int nthreads) {
+  uint64_t written = 0;
+  bool created = false;
+  try {
+    container_file out(output, true);
+    created = true;
+    written = decompress_file(input, out, nthreads);
+    out.close();
+  } catch (...) {
+    if (created) std::remove(output.c_str());
+    throw;
+  }
+  return (double)written;
+}
+
+// Recompresses a container with other settings. Chunks are decompressed by
+// the workers of a reader and compressed by those of a writer, so only a few
+// chunks are held in memory. A `chunk_size` of zero keeps the chunk size of
+// `input`.
+[[cpp11::register]]
+double blosc_recompress_file_(std::string input, std::string output,
+                              std::string compressor, int level, int doshuffle,
+                              int typesize, double chunk_size, int nthreads) {
+  uint64_t written = 0, nbytes = 0;
+  bool created = false;
+  try {
+    container_file in(input, false);
+    container_reader reader(in.source(), nthreads);
+    size_t cs = chunk_size > 0 ? (size_t)chunk_size : reader.chunk_bytes();
+    container_file out(output, true);
+    created = true;
+    container_sink sink = out.sink();
+    container_writer writer([&sink, &written](const uint8_t *p, size_t n) {
+      sink(p, n);
+      written += n;
+    }, compressor, level, doshuffle, typesize, cs, nthreads);
+    std::vector<uint8_t> buffer(cs);
+    size_t n;
+    while ((n = reader.read(buffer.data(), buffer.size())) > 0) {
+      writer.write(buffer.data(), n);
+      nbytes += n;
+      check_user_interrupt();
+    }
+    check_footer(input, nbytes);
+    writer.finish();
+    out.close();
+  } catch (...) {
+    if (created) std::remove(output.c_str());
+    throw;
+  }
+  return (double)written;
+}
+
+// Decompresses `length` bytes starting at `offset` into a raw vector. Only
+// the chunks that overlap with the range are read and decompressed (in
+// parallel), straight from the mapped file into the result.
+[[cpp11::register]]
+raws blosc_read_file_(std::string input, double offset, double length, int nthreads) {
+  mapped_file map(input);
+  container_index index = container_parse_index(map.data(), map.size());
+  uint64_t start = (uint64_t)offset, total = index.footer.nbytes;
+  if (offset < 0 || start > total) stop("`offset` is beyond the end of the data");
+  uint64_t n = length < 0 ? total - start : std::min((uint64_t)length, total - start);
+  writable::raws result((R_xlen_t)n);
+  if (n == 0) return result;
+  uint8_t *dest = (uint8_t *)RAW(as_sexp(result));
+
+  size_t cs = index.chunk_size;
+  size_t first = (size_t)(start / cs), last = (size_t)((start + n - 1) / cs);
+  const container_entry &e_first = index.entries[first], &e_last = index.entries[last];
+  size_t range_start = (size_t)e_first.offset;
+  size_t range_size = (size_t)(e_last.offset + e_last.cbytes - e_first.offset);
+  // Chunks are decompressed out of order by workers, so the read ahead for
+  // sequential access is of little use. The kernel is asked to read the
+  // chunks involved instead, and to refrain from reading ahead elsewhere.
+  if (range_size < map.size() / 2)
+    map.advise(0, map.size(), mapped_file::ACCESS_RANDOM);
+  map.advise(range_start, range_size, mapped_file::ACCESS_WILLNEED);
+
+  parallel_for(last - first + 1, nthreads, [&](size_t j) {
+    size_t i = first + j;
+    uint64_t chunk_start = (uint64_t)i * cs;
+    size_t nbytes = container_chunk_nbytes(index, i);
+    uint64_t from = std::max(start, chunk_start);
+    uint64_t to = std::min(start + n, chunk_start + nbytes);
+    if (from == chunk_start && to == chunk_start + nbytes) {
+      decompress_mapped_chunk(map, index, i, dest + (chunk_start - start));
+    } else {
+      std::vector<uint8_t> buffer(nbytes);
+      decompress_mapped_chunk(map, index, i, buffer.data());
+      memcpy(dest + (from - start), buffer.data() + (from - chunk_start), to - from);
+    }
+  });
+  return result;
+}
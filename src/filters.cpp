@@ -0,0 +1,247 @@
+#include <Rconfig.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "filters.h"
+
+// The kernels below are simple loops over unsigned integers (such that
+// overflow wraps around), which compilers can vectorise.
+
+template <typename T>
+static void delta_forward(T *x, size_t n) {
+  for (size_t i = n; i-- > 1;) x[i] -= x[i - 1];
+}
+
+template <typename T>
+static void delta_inverse(T *x, size_t n) {
+  for (size_t i = 1; i < n; i++) x[i] += x[i - 1];
+}
+
+template <typename T, typename S>
+static T for_reference(const T *x, size_t n) {
+  if (n == 0) return 0;
+  S ref = (S)x[0];
+  for (size_t i = 1; i < n; i++) ref = std::min(ref, (S)x[i]);
+  return (T)ref;
+}
+
+template <typename T>
+static void for_forward(T *x, size_t n, T ref) {
+  for (size_t i = 0; i < n; i++) x[i] -= ref;
+}
+
+template <typename T>
+static void for_inverse(T *x, size_t n, T ref) {
+  for (size_t i = 0; i < n; i++) x[i] += ref;
+}
+
+// Round to the nearest value with `keepbits` mantissa bits (ties to even),
+// like numcodecs' BitRound. Non-finite values (including R's NA) are kept.
+template <typename T>
+static void bitround_forward(T *x, size_t n, int keepbits) {
+  const int mbits = sizeof(T) == 4 ? 23 : 52;
+  if (keepbits >= mbits) return;
+  const int maskbits = mbits - keepbits;
+  const T mask = ~(T)0 << maskbits;
+  const T half = ((T)1 << (maskbits - 1)) - 1;
+  const T expmask = sizeof(T) == 4 ? (T)0x7F800000ull : (T)0x7FF0000000000000ull;
+  for (size_t i = 0; i < n; i++) {
+    T b = x[i];
+    T r = (b + ((b >> maskbits) & 1) + half) & mask;
+    x[i] = (b & expmask) == expmask ? b : r;
+  }
+}
+
+// Round to multiples of the largest power of 2 not exceeding twice the
+// tolerance, such that the error never exceeds the tolerance and trailing
+// mantissa bits become zero
+template <typename T, typename F>
+static void quantize_forward(T *x, size_t n, double tolerance) {
+  const double q = std::exp2(std::floor(std::log2(2 * tolerance)));
+  for (size_t i = 0; i < n; i++) {
+    F v;
+    memcpy(&v, x + i, sizeof(F));
+    if (std::isfinite(v)) v = (F)(std::nearbyint(v / q) * q);
+    memcpy(x + i, &v, sizeof(F));
+  }
+}
+
+template <typename T, typename F>
+static void lossy_impl(const blosc_filter &f, T *x, size_t n) {
+  if (f.id == FILTER_BITROUND) {
+    bitround_forward(x, n, (int)f.param);
+  } else {
+    double tolerance;
+    memcpy(&tolerance, &f.param, sizeof(double));
+    quantize_forward<T, F>(x, n, tolerance);
+  }
+}
+
+static void lossy_forward(const blosc_filter &f, uint32_t *x, size_t n) {
+  lossy_impl<uint32_t, float>(f, x, n);
+}
+
+static void lossy_forward(const blosc_filter &f, uint64_t *x, size_t n) {
+  lossy_impl<uint64_t, double>(f, x, n);
+}
+
+template <typename T>
+static void lossy_forward(const blosc_filter &, T *, size_t) {
+  throw std::runtime_error("Lossy filters require 4 or 8 byte floating point data");
+}
+
+template <typename T>
+static void swap_elements(T *x, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint8_t *b = (uint8_t *)(x + i);
+    for (size_t k = 0; k < sizeof(T) / 2; k++) std::swap(b[k], b[sizeof(T) - 1 - k]);
+  }
+}
+
+static bool needs_swap(const blosc_filter &f) {
+#ifdef WORDS_BIGENDIAN
+  return (f.flags & FILTER_BIG_ENDIAN) == 0;
+#else
+  return (f.flags & FILTER_BIG_ENDIAN) != 0;
+#endif
+}
+
+template <typename T, typename S>
+static void apply_filter(blosc_filter &f, uint8_t *data, size_t nbytes, bool forward) {
+  T *x = (T *)data;
+  size_t n = nbytes / sizeof(T);
+  bool swap = needs_swap(f);
+  if (swap) swap_elements(x, n);
+  if (f.id == FILTER_DELTA) {
+    if (forward) delta_forward(x, n); else delta_inverse(x, n);
+  } else if (f.id == FILTER_FOR) {
+    if (forward) {
+      T ref = (f.flags & FILTER_SIGNED) ? for_reference<T, S>(x, n) :
+        for_reference<T, T>(x, n);
+      f.param = (uint64_t)ref;
+      for_forward(x, n, ref);
+    } else {
+      for_inverse(x, n, (T)f.param);
+    }
+  } else if (f.id == FILTER_BITROUND || f.id == FILTER_QUANTIZE) {
+    // Lossy filters cannot be inverted
+    if (forward) lossy_forward(f, x, n);
+  } else {
+    throw std::runtime_error("Unknown filter");
+  }
+  if (swap) swap_elements(x, n);
+}
+
+static void apply(blosc_filter &f, uint8_t *data, size_t nbytes, bool forward) {
+  switch (f.size) {
+  case 1:
+    apply_filter<uint8_t, int8_t>(f, data, nbytes, forward);
+    break;
+  case 2:
+    apply_filter<uint16_t, int16_t>(f, data, nbytes, forward);
+    break;
+  case 4:
+    apply_filter<uint32_t, int32_t>(f, data, nbytes, forward);
+    break;
+  case 8:
+    apply_filter<uint64_t, int64_t>(f, data, nbytes, forward);
+    break;
+  default:
+    throw std::runtime_error("Filters require an element size of 1, 2, 4 or 8 bytes");
+  }
+}
+
+blosc_filter filter_create(const std::string &name, int size, bool big_endian,
+                           bool is_signed, double param) {
+  blosc_filter f;
+  f.param = 0;
+  if (name == "delta") {
+    f.id = FILTER_DELTA;
+  } else if (name == "for") {
+    f.id = FILTER_FOR;
+  } else if (name == "bitround") {
+    f.id = FILTER_BITROUND;
+  } else if (name == "quantize") {
+    f.id = FILTER_QUANTIZE;
+    if (!(param > 0) || !std::isfinite(param))
+      throw std::runtime_error("Tolerance should be a positive number");
+    memcpy(&f.param, &param, sizeof(double));
+  } else {
+    throw std::runtime_error("Unknown filter '" + name + "'");
+  }
+  if (size != 1 && size != 2 && size != 4 && size != 8)
+    throw std::runtime_error("Filters require an element size of 1, 2, 4 or 8 bytes");
+  if ((f.id == FILTER_BITROUND || f.id == FILTER_QUANTIZE) && size != 4 && size != 8)
+    throw std::runtime_error("Lossy filters require 4 or 8 byte floating point data");
+  if (f.id == FILTER_BITROUND) {
+    // Number of mantissa bits of single and double precision floats
+    int mbits = size == 4 ? 23 : 52;
+    if (!(param >= 0 && param <= mbits))
+      throw std::runtime_error("Number of bits to keep should be between 0 and " +
+                               std::to_string(mbits));
+    f.param = (uint64_t)param;
+  }
+  f.size = (uint8_t)size;
+  f.flags = (big_endian ? FILTER_BIG_ENDIAN : 0) | (is_signed ? FILTER_SIGNED : 0);
+  return f;
+}
+
+void filters_forward(std::vector<blosc_filter> &filters, uint8_t *data, size_t nbytes) {
+  for (auto &f : filters) apply(f, data, nbytes, true);
+}
+
+void filters_inverse(const std::vector<blosc_filter> &filters, uint8_t *data,
+                     size_t nbytes) {
+  for (size_t i = filters.size(); i-- > 0;) {
+    blosc_filter f = filters[i];
+    apply(f, data, nbytes, false);
+  }
+}
+
+// Each filter is stored as 12 bytes: id, size, flags, a reserved byte and
+// its parameter (uint64 LE)
+ext_section filters_section(const std::vector<blosc_filter> &filters) {
+  ext_section s;
+  s.id = EXT_FILTERS;
+  s.payload.assign(1 + 12 * filters.size(), 0);
+  s.payload[0] = (uint8_t)filters.size();
+  for (size_t i = 0; i < filters.size(); i++) {
+    uint8_t *p = s.payload.data() + 1 + 12 * i;
+    p[0] = filters[i].id;
+    p[1] = filters[i].size;
+    p[2] = filters[i].flags;
+    put_u64_le(p + 4, filters[i].param);
+  }
+  return s;
+}
+
+std::vector<blosc_filter> filters_from_header(const std::vector<ext_section> &sections) {
+  std::vector<blosc_filter> result;
+  const ext_section *s = ext_header_find(sections, EXT_FILTERS);
+  if (s == nullptr) return result;
+  if (s->payload.empty() || s->payload.size() != 1 + 12 * (size_t)s->payload[0])
+    throw std::runtime_error("Corrupt filter section in extension header");
+  for (size_t i = 0; i < s->payload[0]; i++) {
+    const uint8_t *p = s->payload.data() + 1 + 12 * i;
+    result.push_back({p[0], p[1], p[2], get_u64_le(p + 4)});
+  }
+  return result;
+}
+
+std::string filter_name(const blosc_filter &filter) {
+  switch (filter.id) {
+  case FILTER_DELTA:
+    return "delta";
+  case FILTER_FOR:
+    return "for";
+  case FILTER_BITROUND:
+    return "bitround";
+  case FILTER_QUANTIZE:
+    return "quantize";
+  default:
+    return "unknown";
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef BLOSC_FILTERS_H
+#define BLOSC_FILTERS_H
+
+#include <string>
+#include <vector>
+#include "header.h"
+
+// Filters transform data before it is shuffled and compressed. They are
+// recorded in the `EXT_FILTERS` section of the extension header (see
+// `header.h`) and inverted in reverse order after decompression.
+
+enum filter_id : uint8_t {
+  FILTER_DELTA    = 1, // Differences between consecutive integers
+  FILTER_FOR      = 2, // Frame of reference: integers minus their minimum
+  FILTER_BITROUND = 3, // Keep `param` mantissa bits of floats (lossy)
+  FILTER_QUANTIZE = 4  // Round floats to an absolute tolerance (lossy)
+};
+
+// Filter flags
+#define FILTER_BIG_ENDIAN 0x01
+#define FILTER_SIGNED     0x02
+
+typedef struct {
+  uint8_t id;
+  uint8_t size;   // element size in bytes
+  uint8_t flags;
+  uint64_t param; // e.g. the reference value of FILTER_FOR
+} blosc_filter;
+
+// Create a filter from its name ("delta", "for", "bitround" or "quantize").
+// `param` is the number of mantissa bits to keep for "bitround" and the
+// tolerance for "quantize"; it is ignored by the other filters.
+blosc_filter filter_create(const std::string &name, int size, bool big_endian,
+                           bool is_signed, double param = 0);
+// Apply `filters` in order to `data`, setting parameters that depend on data
+void filters_forward(std::vector<blosc_filter> &filters, uint8_t *data, size_t nbytes);
+// Invert `filters` in reverse order. Lossy filters are left as is.
+void filters_inverse(const std::vector<blosc_filter> &filters, uint8_t *data,
+                     size_t nbytes);
+ext_section filters_section(const std::vector<blosc_filter> &filters);
+// Filters recorded in the extension header (empty when there are none)
+std::vector<blosc_filter> filters_from_header(const std::vector<ext_section> &sections);
+std::string filter_name(const blosc_filter &filter);
+
+#endif /* BLOSC_FILTERS_H */
@@ -0,0 +1,55 @@
+#include <cstring>
+#include <stdexcept>
+#include "header.h"
+
+static const uint8_t blxh_magic[4] = {0x42, 0x4C, 0x58, 0x48};
+
+std::vector<uint8_t> ext_header_encode(const std::vector<ext_section> &sections) {
+  if (sections.size() > 255) throw std::runtime_error("Too many header sections");
+  size_t total = BLXH_FIXED_SIZE;
+  for (auto &s : sections) total += 8 + s.payload.size();
+  std::vector<uint8_t> result(total, 0);
+  memcpy(result.data(), blxh_magic, 4);
+  result[4] = BLXH_VERSION;
+  result[5] = (uint8_t)sections.size();
+  put_u32_le(result.data() + 8, (uint32_t)total);
+  size_t pos = BLXH_FIXED_SIZE;
+  for (auto &s : sections) {
+    result[pos] = s.id;
+    put_u32_le(result.data() + pos + 4, (uint32_t)s.payload.size());
+    if (!s.payload.empty())
+      memcpy(result.data() + pos + 8, s.payload.data(), s.payload.size());
+    pos += 8 + s.payload.size();
+  }
+  return result;
+}
+
+size_t ext_header_parse(const uint8_t *src, size_t size,
+                        std::vector<ext_section> &sections) {
+  sections.clear();
+  if (size < 4 || memcmp(src, blxh_magic, 4) != 0) return 0;
+  if (size < BLXH_FIXED_SIZE) throw std::runtime_error("Truncated extension header");
+  if (src[4] > BLXH_VERSION)
+    throw std::runtime_error("Extension header was written by a newer version of blosc");
+  size_t total = get_u32_le(src + 8);
+  if (total < BLXH_FIXED_SIZE || total > size)
+    throw std::runtime_error("Corrupt extension header");
+  size_t pos = BLXH_FIXED_SIZE;
+  for (int i = 0; i < src[5]; i++) {
+    if (pos + 8 > total) throw std::runtime_error("Corrupt extension header");
+    ext_section s;
+    s.id = src[pos];
+    size_t len = get_u32_le(src + pos + 4);
+    if (pos + 8 + len > total) throw std::runtime_error("Corrupt extension header");
+    s.payload.assign(src + pos + 8, src + pos + 8 + len);
+    sections.push_back(std::move(s));
+    pos += 8 + len;
+  }
+  return total;
+}
+
+const ext_section *ext_header_find(const std::vector<ext_section> &sections,
+                                   uint8_t id) {
+  for (auto &s : sections) if (s.id == id) return &s;
+  return nullptr;
+}
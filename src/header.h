@@ -0,0 +1,64 @@
+#ifndef BLOSC_HEADER_H
+#define BLOSC_HEADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Blosc buffers can be preceded by a small self-describing extension header,
+// which records how the data was transformed before compression, such that
+// decompression can invert it automatically. The header consists of:
+//
+//   magic "BLXH" (4 bytes), version (1 byte), number of sections (1 byte),
+//   2 reserved bytes, total header length including the magic (uint32 LE)
+//
+// followed by sections, each consisting of an id (1 byte), 3 reserved bytes,
+// the length of the payload (uint32 LE) and the payload itself. A blosc1
+// buffer starts with its format version (2), so it can never be mistaken
+// for an extension header.
+
+#define BLXH_VERSION 1
+#define BLXH_FIXED_SIZE 12
+
+enum ext_section_id : uint8_t {
+  EXT_FILTERS = 1,
+  EXT_STATS   = 2,
+  EXT_DICT    = 3,
+  EXT_LEVELS  = 4
+};
+
+typedef struct {
+  uint8_t id;
+  std::vector<uint8_t> payload;
+} ext_section;
+
+// Encodes `sections` as an extension header
+std::vector<uint8_t> ext_header_encode(const std::vector<ext_section> &sections);
+// Parses the extension header at the start of `src` (if any) into `sections`.
+// Returns the length of the header, i.e. the offset of the blosc buffer
+size_t ext_header_parse(const uint8_t *src, size_t size,
+                        std::vector<ext_section> &sections);
+// Returns the section with id `id`, or `nullptr` when it is absent
+const ext_section *ext_header_find(const std::vector<ext_section> &sections,
+                                   uint8_t id);
+
+// Integers in headers and indices are always stored in little endian order
+inline uint32_t get_u32_le(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+    ((uint32_t)p[3] << 24);
+}
+
+inline void put_u32_le(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+inline uint64_t get_u64_le(const uint8_t *p) {
+  return (uint64_t)get_u32_le(p) | ((uint64_t)get_u32_le(p + 4) << 32);
+}
+
+inline void put_u64_le(uint8_t *p, uint64_t v) {
+  put_u32_le(p, (uint32_t)v);
+  put_u32_le(p + 4, (uint32_t)(v >> 32));
+}
+
+#endif /* BLOSC_HEADER_H */
@@ -0,0 +1,113 @@
+#ifndef BLOSC_LRU_H
+#define BLOSC_LRU_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// A map with a bounded total size in bytes. When an insertion exceeds the
+// budget, the least recently used entries are evicted. Hits, misses and
+// evictions are counted. It is not thread-safe: wrap it with a mutex when
+// it is shared by workers.
+template <class Key, class Value, class Hash = std::hash<Key>>
+class lru_cache {
+public:
+  explicit lru_cache(size_t max_bytes) : budget(max_bytes) {}
+
+  // Pointer to the value of `key`, or `nullptr` when it is absent. The entry
+  // becomes the most recently used. The pointer remains valid until the
+  // cache is modified.
+  Value *get(const Key &key) {
+    auto it = map.find(key);
+    if (it == map.end()) {
+      n_misses++;
+      return nullptr;
+    }
+    n_hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->value;
+  }
+
+  // Inserts or replaces the value of `key`, which occupies `bytes`. Values
+  // that do not fit in the budget are not stored, and `false` is returned.
+  bool put(const Key &key, Value value, size_t bytes) {
+    erase(key);
+    if (bytes > budget) return false;
+    entries.push_front({key, std::move(value), bytes});
+    map[key] = entries.begin();
+    used += bytes;
+    evict();
+    return true;
+  }
+
+  bool erase(const Key &key) {
+    auto it = map.find(key);
+    if (it == map.end()) return false;
+    used -= it->second->bytes;
+    entries.erase(it->second);
+    map.erase(it);
+    return true;
+  }
+
+  // Removes all entries of which the key satisfies `pred`
+  template <class Pred>
+  void erase_if(Pred pred) {
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (pred(it->key)) {
+        used -= it->bytes;
+        map.erase(it->key);
+        it = entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void clear() {
+    entries.clear();
+    map.clear();
+    used = 0;
+  }
+
+  // Changes the budget, evicting entries when it shrinks
+  void set_max_bytes(size_t max_bytes) {
+    budget = max_bytes;
+    evict();
+  }
+
+  size_t max_bytes() const { return budget; }
+  size_t bytes() const { return used; }
+  size_t size() const { return entries.size(); }
+  uint64_t hits() const { return n_hits; }
+  uint64_t misses() const { return n_misses; }
+  uint64_t evictions() const { return n_evictions; }
+
+private:
+  struct entry {
+    Key key;
+    Value value;
+    size_t bytes;
+  };
+
+  void evict() {
+    while (used > budget && !entries.empty()) {
+      used -= entries.back().bytes;
+      map.erase(entries.back().key);
+      entries.pop_back();
+      n_evictions++;
+    }
+  }
+
+  size_t budget;
+  size_t used = 0;
+  uint64_t n_hits = 0;
+  uint64_t n_misses = 0;
+  uint64_t n_evictions = 0;
+  std::list<entry> entries;
+  std::unordered_map<Key, typename std::list<entry>::iterator, Hash> map;
+};
+
+#endif /* BLOSC_LRU_H */
@@ -0,0 +1,104 @@
+#ifndef BLOSC_MAPPED_H
+#define BLOSC_MAPPED_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A read-only memory map of a file, such that its content can be used
+// without copying it. Reading the mapped memory from workers is safe.
+// Errors are thrown as C++ exceptions. On Windows, where `<windows.h>`
+// conflicts with R's headers, the file is read into memory instead.
+class mapped_file {
+public:
+  enum access_pattern {
+    ACCESS_SEQUENTIAL, // The range is read from start to end
+    ACCESS_RANDOM,     // Only small parts of the range are read
+    ACCESS_WILLNEED    // The range is read soon
+  };
+
+  explicit mapped_file(const std::string &path) {
+#ifdef _WIN32
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) throw std::runtime_error("Failed to open file '" + path + "'");
+    bool ok = _fseeki64(f, 0, SEEK_END) == 0;
+    long long size = ok ? _ftelli64(f) : -1;
+    ok = size >= 0 && _fseeki64(f, 0, SEEK_SET) == 0;
+    if (ok) {
+      buffer.resize((size_t)size);
+      ok = std::fread(buffer.data(), 1, buffer.size(), f) == buffer.size();
+    }
+    std::fclose(f);
+    if (!ok) throw std::runtime_error("Failed to read file '" + path + "'");
+    map = buffer.data();
+    map_size = buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Failed to open file '" + path + "'");
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Failed to read file '" + path + "'");
+    }
+    map_size = (size_t)st.st_size;
+    if (map_size > 0) map = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping remains valid after closing the file
+    ::close(fd);
+    if (map == MAP_FAILED) {
+      map = nullptr;
+      throw std::runtime_error("Failed to map file '" + path + "'");
+    }
+#endif
+  }
+
+  ~mapped_file() {
+#ifndef _WIN32
+    if (map != nullptr) munmap(map, map_size);
+#endif
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  const uint8_t *data() const {
+    return (const uint8_t *)map;
+  }
+
+  size_t size() const {
+    return map_size;
+  }
+
+  // Informs the kernel how `n` bytes starting at `offset` will be accessed,
+  // such that it can adjust read ahead. It is only a hint.
+  void advise(size_t offset, size_t n, access_pattern pattern) const {
+#ifndef _WIN32
+    if (map == nullptr || offset >= map_size) return;
+    // `madvise()` requires an address aligned to pages
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset - offset % page;
+    n = std::min(n + (offset - start), map_size - start);
+    int advice = pattern == ACCESS_SEQUENTIAL ? MADV_SEQUENTIAL :
+      pattern == ACCESS_RANDOM ? MADV_RANDOM : MADV_WILLNEED;
+    madvise((uint8_t *)map + start, n, advice);
+#endif
+  }
+
+private:
+  void *map = nullptr;
+  size_t map_size = 0;
+#ifdef _WIN32
+  std::vector<uint8_t> buffer;
+#endif
+};
+
+#endif /* BLOSC_MAPPED_H */
@@ -0,0 +1,48 @@
+#ifndef BLOSC_PARALLEL_H
+#define BLOSC_PARALLEL_H
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Call `fn(i)` for each `i` in `[0, n)` using up to `nthreads` threads.
+// `fn` is executed outside of R's main thread, so it should never call the
+// R API (including `cpp11::stop()`). Throw a regular C++ exception instead:
+// the first one caught is rethrown on the calling thread after all workers
+// have finished.
+template <typename F>
+void parallel_for(size_t n, int nthreads, F fn) {
+  if (nthreads < 1) nthreads = 1;
+  if ((size_t)nthreads > n) nthreads = (int)n;
+  if (nthreads <= 1) {
+    for (size_t i = 0; i < n; i++) fn(i);
+    return;
+  }
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  std::exception_ptr error = nullptr;
+  std::mutex error_mutex;
+
+  auto worker = [&]() {
+    size_t i;
+    while (!failed && (i = next++) < n) {
+      try {
+        fn(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int t = 1; t < nthreads; t++) pool.emplace_back(worker);
+  worker();
+  for (auto &th : pool) th.join();
+  if (error) std::rethrow_exception(error);
+}
+
+#endif /* BLOSC_PARALLEL_H */
@@ -0,0 +1,89 @@
+#ifndef BLOSC_PIPELINE_H
+#define BLOSC_PIPELINE_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A pool of worker threads that consume tasks submitted by the main thread.
+// `submit()` blocks while `max_pending` tasks are waiting, which bounds the
+// memory held by queued tasks. Like with `parallel_for()`, tasks should never
+// call the R API, but throw C++ exceptions instead. The first exception is
+// rethrown on the main thread by `submit()` or `wait()`.
+class task_queue {
+public:
+  task_queue(int nthreads, size_t max_pending) :
+  max_pending(max_pending < 1 ? 1 : max_pending) {
+    if (nthreads < 1) nthreads = 1;
+    for (int i = 0; i < nthreads; i++) workers.emplace_back([this]() { run(); });
+  }
+
+  // Pending tasks are discarded when the queue is destroyed before `wait()`
+  // was called (for instance when unwinding after an error)
+  ~task_queue() {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stopping = true;
+    }
+    cv_task.notify_all();
+    for (auto &w : workers) w.join();
+  }
+
+  task_queue(const task_queue&) = delete;
+  task_queue& operator=(const task_queue&) = delete;
+
+  void submit(std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv_done.wait(lock, [this]() { return tasks.size() < max_pending || error; });
+    if (error) std::rethrow_exception(error);
+    tasks.push_back(std::move(task));
+    cv_task.notify_one();
+  }
+
+  // Wait until all submitted tasks are finished
+  void wait() {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv_done.wait(lock, [this]() { return (tasks.empty() && active == 0) || error; });
+    if (error) std::rethrow_exception(error);
+  }
+
+private:
+  size_t max_pending;
+  size_t active = 0;
+  bool stopping = false;
+  std::exception_ptr error = nullptr;
+  std::deque<std::function<void()>> tasks;
+  std::vector<std::thread> workers;
+  std::mutex mtx;
+  std::condition_variable cv_task;
+  std::condition_variable cv_done;
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+      cv_task.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if (stopping) return;
+      std::function<void()> task = std::move(tasks.front());
+      tasks.pop_front();
+      active++;
+      cv_done.notify_all();
+      lock.unlock();
+      try {
+        task();
+      } catch (...) {
+        lock.lock();
+        if (!error) error = std::current_exception();
+        lock.unlock();
+      }
+      lock.lock();
+      active--;
+      cv_done.notify_all();
+    }
+  }
+};
+
+#endif /* BLOSC_PIPELINE_H */
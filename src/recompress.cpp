@@ -0,0 +1,87 @@
+#include <cpp11.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "backend.h"
+#include "header.h"
+#include "parallel.h"
+
+using namespace cpp11;
+
+// Recompresses the blosc buffer `src` with other settings, without using
+// the R API. Filters are not inverted, so the filtered data is recompressed
+// and the extension header keeps its filters section. Block statistics
+// depend on the block size, and are dropped. A `typesize` below 1 keeps
+// the type size of `src`.
+static std::vector<uint8_t> recompress_buffer(const uint8_t *src, size_t size,
+                                              const std::string &compressor,
+                                              int level, int doshuffle, int typesize,
+                                              int nthreads) {
+  std::vector<ext_section> sections;
+  size_t offset = ext_header_parse(src, size, sections);
+  if (ext_header_find(sections, EXT_DICT) != nullptr)
+    throw std::runtime_error("Data compressed with a dictionary cannot be recompressed");
+  src += offset;
+  size -= offset;
+  size_t nbytes = 0;
+  if (backend_cbuffer_validate(src, size, &nbytes) < 0)
+    throw std::runtime_error("Unable to decompress data");
+  if (typesize < 1) {
+    size_t ts = 0;
+    int flags = 0;
+    backend_cbuffer_metainfo(src, &ts, &flags);
+    typesize = (int)ts;
+  }
+  std::vector<uint8_t> plain(nbytes);
+  if (backend_decompress(src, size, plain.data(), nbytes, nthreads) < 0)
+    throw std::runtime_error("Failed to decompress data");
+
+  sections.erase(std::remove_if(sections.begin(), sections.end(),
+                                [](const ext_section &s) { return s.id == EXT_STATS; }),
+                 sections.end());
+  std::vector<uint8_t> result;
+  if (!sections.empty()) result = ext_header_encode(sections);
+  size_t hs = result.size();
+  result.resize(hs + nbytes + BACKEND_MAX_OVERHEAD);
+  int out = backend_compress(level, doshuffle, typesize, nbytes, plain.data(),
+                             result.data() + hs, result.size() - hs,
+                             compressor.c_str(), 0, nthreads);
+  if (out < 0) throw std::runtime_error("BLOSC compressor failed!");
+  result.resize(hs + (size_t)out);
+  return result;
+}
+
+// Recompresses each buffer of `data`. Buffers are processed by workers,
+// each holding one decompressed buffer at a time. When there are fewer
+// buffers than threads, blosc splits the blocks of a buffer over the
+// remaining threads.
+[[cpp11::register]]
+list blosc_recompress_(list data, std::string compressor, int level, int doshuffle,
+                       int typesize, int nthreads) {
+  size_t n = (size_t)data.size();
+  std::vector<const uint8_t *> src(n);
+  std::vector<size_t> size(n);
+  for (size_t i = 0; i < n; i++) {
+    SEXP x = data[(R_xlen_t)i];
+    if (TYPEOF(x) != RAWSXP) stop("Data to recompress should be raw vectors");
+    src[i] = (const uint8_t *)RAW(x);
+    size[i] = (size_t)Rf_xlength(x);
+  }
+  int inner = n == 0 || n >= (size_t)std::max(nthreads, 1) ? 1 : nthreads / (int)n;
+  std::vector<std::vector<uint8_t>> results(n);
+  parallel_for(n, nthreads, [&](size_t i) {
+    results[i] = recompress_buffer(src[i], size[i], compressor, level, doshuffle,
+                                   typesize, inner);
+  });
+
+  writable::list result((R_xlen_t)n);
+  for (size_t i = 0; i < n; i++) {
+    writable::raws x((R_xlen_t)results[i].size());
+    memcpy(RAW(as_sexp(x)), results[i].data(), results[i].size());
+    // Release each buffer once copied, to limit peak memory use
+    std::vector<uint8_t>().swap(results[i]);
+    result[(R_xlen_t)i] = x;
+  }
+  return result;
+}
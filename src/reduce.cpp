@@ -0,0 +1,80 @@
+#include <cpp11.hpp>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "dtype.h"
+#include "parallel.h"
+#include "scan.h"
+
+using namespace cpp11;
+
+// Summary of the elements of a chunk
+typedef struct {
+  long double sum;
+  double min;
+  double max;
+  double count;    // number of non-missing elements
+  double count_na; // number of missing elements
+} reduce_partial;
+
+static void reduce_values(const std::vector<double> &values, reduce_partial &p) {
+  long double sum = 0;
+  double mn = std::numeric_limits<double>::infinity(), mx = -mn;
+  size_t n_na = 0;
+  for (double v : values) {
+    if (std::isnan(v)) {
+      n_na++;
+      continue;
+    }
+    sum += v;
+    mn = v < mn ? v : mn;
+    mx = v > mx ? v : mx;
+  }
+  p = {sum, mn, mx, (double)(values.size() - n_na), (double)n_na};
+}
+
+[[cpp11::register]]
+double blosc_reduce_(raws data, std::string dtype, std::string fun, sexp na_value,
+                     bool na_rm, int nthreads) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  blosc_na na = resolve_na(na_value, scan_rtype(dt));
+  typed_scan scan((const uint8_t *)RAW(data), (size_t)data.size(), dt, na);
+
+  // Chunks are decoded and summarised by workers, and combined in order.
+  // Recorded statistics answer all but sums, unless values are mapped to
+  // missing values.
+  bool use_stats = fun != "sum" && fun != "mean" && !scan.maps_na();
+  std::vector<reduce_partial> partials(scan.nchunks());
+  parallel_for(scan.nchunks(), nthreads, [&](size_t c) {
+    const block_stats *s = scan.chunk_stats(c);
+    if (use_stats && s != nullptr) {
+      double n_na = (double)s->n_na;
+      partials[c] = {0, s->min, s->max, (double)scan.chunk_length(c) - n_na, n_na};
+      return;
+    }
+    std::vector<uint8_t> scratch;
+    std::vector<double> values;
+    scan.decode(c, scratch, values);
+    reduce_values(values, partials[c]);
+  });
+  reduce_partial total = {0, std::numeric_limits<double>::infinity(),
+                          -std::numeric_limits<double>::infinity(), 0, 0};
+  for (const reduce_partial &p : partials) {
+    total.sum += p.sum;
+    total.min = std::min(total.min, p.min);
+    total.max = std::max(total.max, p.max);
+    total.count += p.count;
+    total.count_na += p.count_na;
+  }
+
+  if (fun == "count_na") return total.count_na;
+  if (total.count_na > 0 && !na_rm) return NA_REAL;
+  if (fun == "sum") return (double)total.sum;
+  if (fun == "mean") return total.count == 0 ? R_NaN : (double)(total.sum / total.count);
+  if (total.count == 0)
+    warning("No non-missing values to compute the %s; returning %s", fun.c_str(),
+            fun == "min" ? "Inf" : "-Inf");
+  if (fun == "min") return total.min;
+  if (fun == "max") return total.max;
+  stop("Unknown function '%s'", fun.c_str());
+}
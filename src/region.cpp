@@ -0,0 +1,72 @@
+#include <cpp11.hpp>
+#include <vector>
+#include "blocks.h"
+#include "dtype.h"
+#include "filters.h"
+#include "header.h"
+
+using namespace cpp11;
+
+[[cpp11::register]]
+sexp blosc_decompress_region_(raws data, std::string dtype, integers chunk_shape,
+                              integers start, integers count, integers step,
+                              std::string order, sexp na_value) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  size_t item_size = (size_t)dtype_item_size(dt);
+  size_t ndim = (size_t)chunk_shape.size();
+  if ((size_t)start.size() != ndim || (size_t)count.size() != ndim ||
+      (size_t)step.size() != ndim)
+    stop("`start`, `count` and `step` should have an element for each dimension");
+  if (order != "C" && order != "F") stop("Unknown order '%s'", order.c_str());
+
+  // Element strides within the chunk
+  std::vector<size_t> chunk_stride(ndim);
+  size_t chunk_items = 1, n_out = 1;
+  for (size_t k = 0; k < ndim; k++) {
+    size_t d = order == "C" ? ndim - 1 - k : k;
+    chunk_stride[d] = chunk_items;
+    chunk_items *= (size_t)chunk_shape[d];
+    n_out *= (size_t)count[d];
+  }
+
+  const uint8_t *src = (const uint8_t *)RAW(data);
+  std::vector<ext_section> sections;
+  size_t offset = ext_header_parse(src, (size_t)data.size(), sections);
+  if (ext_header_find(sections, EXT_DICT) != nullptr)
+    stop("Data compressed with a dictionary can only be decompressed entirely");
+  blosc_blocks blocks(src + offset, (size_t)data.size() - offset,
+                      block_cache_buffer_id(data));
+  if (blocks.nbytes() != chunk_items * item_size)
+    stop("Size of decompressed data does not match `chunk_shape` and `dtype`");
+  // Filters (like delta coding) cannot be inverted for individual blocks,
+  // so filtered data is decompressed entirely
+  std::vector<blosc_filter> filters = filters_from_header(sections);
+  std::vector<uint8_t> flat;
+  if (!filters.empty()) {
+    flat.resize(blocks.nbytes());
+    blocks.copy(0, flat.size(), flat.data());
+    filters_inverse(filters, flat.data(), flat.size());
+  }
+
+  // Gather the selected elements in R's (column-major) order. Only blocks that
+  // contain selected elements are decompressed.
+  writable::raws selected((R_xlen_t)(n_out * item_size));
+  uint8_t *dest = (uint8_t *)RAW(selected);
+  std::vector<int> pos(ndim, 0);
+  for (size_t i = 0; i < n_out; i++) {
+    size_t el = 0;
+    for (size_t d = 0; d < ndim; d++)
+      el += ((size_t)start[d] + (size_t)pos[d] * step[d]) * chunk_stride[d];
+    if (flat.empty()) {
+      blocks.copy(el * item_size, item_size, dest + i * item_size);
+    } else {
+      memcpy(dest + i * item_size, flat.data() + el * item_size, item_size);
+    }
+    for (size_t d = 0; d < ndim; d++) {
+      if (++pos[d] < count[d]) break;
+      pos[d] = 0;
+    }
+  }
+
+  return dtype_to_r_(selected, dtype, na_value);
+}
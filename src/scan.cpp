@@ -0,0 +1,202 @@
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "filters.h"
+#include "header.h"
+#include "scan.h"
+
+// Number of elements per chunk when the buffer is decompressed entirely
+#define SCAN_CHUNK_ITEMS 65536
+
+// Size of a block's statistics in the `EXT_STATS` section
+#define STATS_ENTRY_SIZE 24
+
+static void check_dtype(const blosc_dtype &dt) {
+  if (std::string("biuf").find(dt.main_type) == std::string::npos ||
+      (dt.main_type == 'f' && dt.byte_size == 1))
+    throw std::runtime_error("Only boolean, integer and floating point data can be scanned");
+}
+
+static double get_f64_le(const uint8_t *p) {
+  uint64_t bits = get_u64_le(p);
+  double result;
+  memcpy(&result, &bits, sizeof(double));
+  return result;
+}
+
+static void put_f64_le(uint8_t *p, double v) {
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(double));
+  put_u64_le(p, bits);
+}
+
+int scan_rtype(const blosc_dtype &dt) {
+  if (dt.main_type == 'u' && dt.byte_size == 8) return REALSXP;
+  return dtype_rtype(dt);
+}
+
+typed_scan::typed_scan(const uint8_t *src, size_t size, const blosc_dtype &dtype,
+                       const blosc_na &na) : dt(dtype) {
+  check_dtype(dt);
+  std::vector<ext_section> sections;
+  size_t offset = ext_header_parse(src, size, sections);
+  if (ext_header_find(sections, EXT_DICT) != nullptr)
+    throw std::runtime_error("Data compressed with a dictionary can only be decompressed entirely");
+  blocks.reset(new blosc_blocks(src + offset, size - offset));
+  size_t item = dt.byte_size;
+  if (blocks->nbytes() % item != 0)
+    throw std::runtime_error("Raw data size needs to be multitude of data type size");
+  n_items = blocks->nbytes() / item;
+  std::vector<blosc_filter> filters = filters_from_header(sections);
+  if (!filters.empty() || blocks->blocksize() % item != 0) {
+    // Filters (like delta coding) cannot be inverted for individual blocks
+    flat.resize(blocks->nbytes());
+    if (backend_decompress(src + offset, size - offset, flat.data(), flat.size(), 1) < 0)
+      throw std::runtime_error("Failed to decompress data");
+    filters_inverse(filters, flat.data(), flat.size());
+    chunk_items = SCAN_CHUNK_ITEMS;
+  } else {
+    chunk_items = blocks->blocksize() / item;
+  }
+  n_chunks = n_items == 0 ? 0 : (n_items + chunk_items - 1) / chunk_items;
+  na_value = std::numeric_limits<double>::quiet_NaN();
+  if (!na.ignore)
+    na_value = scan_rtype(dt) == REALSXP ? na.real_value : (double)na.int_value;
+
+  // Statistics are only of use when their blocks are the chunks
+  const ext_section *ssec = ext_header_find(sections, EXT_STATS);
+  if (ssec != nullptr) {
+    const std::vector<uint8_t> &payload = ssec->payload;
+    if (payload.size() < 8 ||
+        (payload.size() - 8) % STATS_ENTRY_SIZE != 0)
+      throw std::runtime_error("Corrupt block statistics");
+    size_t block_items = (size_t)get_u64_le(payload.data());
+    size_t nblocks = (payload.size() - 8) / STATS_ENTRY_SIZE;
+    if (flat.empty() && block_items == chunk_items && nblocks == n_chunks) {
+      stats.resize(nblocks);
+      const uint8_t *p = payload.data() + 8;
+      for (size_t b = 0; b < nblocks; b++, p += STATS_ENTRY_SIZE)
+        stats[b] = {get_f64_le(p), get_f64_le(p + 8), get_u64_le(p + 16)};
+    }
+  }
+}
+
+// The byte order is handled outside of the loops, such that compilers can
+// vectorise them
+template <typename T>
+static void decode_items(const uint8_t *p, size_t n, bool swap, double *dest) {
+  if (!swap) {
+    for (size_t i = 0; i < n; i++) {
+      T v;
+      memcpy(&v, p + i * sizeof(T), sizeof(T));
+      dest[i] = (double)v;
+    }
+  } else {
+    for (size_t i = 0; i < n; i++) {
+      uint8_t b[sizeof(T)];
+      for (size_t j = 0; j < sizeof(T); j++) b[j] = p[(i + 1) * sizeof(T) - j - 1];
+      T v;
+      memcpy(&v, b, sizeof(T));
+      dest[i] = (double)v;
+    }
+  }
+}
+
+// Decodes `count` elements of type `dt` at `p` into `d`. Elements equal to
+// `na_value` (unless NaN) are decoded as NaN.
+static void decode_values(const uint8_t *p, size_t count, const blosc_dtype &dt,
+                          double na_value, double *d) {
+  bool swap = dt.needs_byteswap;
+  char type = dt.main_type;
+  if (type == 'f' && dt.byte_size == 2) {
+    for (size_t i = 0; i < count; i++) {
+      uint16_t v;
+      memcpy(&v, p + 2 * i, 2);
+      if (swap) v = (uint16_t)((v >> 8) | (v << 8));
+      d[i] = float16_to_double(v);
+    }
+  } else if (type == 'f' && dt.byte_size == 4) {
+    decode_items<float>(p, count, swap, d);
+  } else if (type == 'f') {
+    decode_items<double>(p, count, swap, d);
+  } else if (type == 'u' && dt.byte_size == 2) {
+    decode_items<uint16_t>(p, count, swap, d);
+  } else if (type == 'u' && dt.byte_size == 4) {
+    decode_items<uint32_t>(p, count, swap, d);
+  } else if (type == 'u' && dt.byte_size == 8) {
+    decode_items<uint64_t>(p, count, swap, d);
+  } else if (type == 'u') {
+    decode_items<uint8_t>(p, count, swap, d);
+  } else if (dt.byte_size == 2) {
+    decode_items<int16_t>(p, count, swap, d);
+  } else if (dt.byte_size == 4) {
+    decode_items<int32_t>(p, count, swap, d);
+  } else if (dt.byte_size == 8) {
+    decode_items<int64_t>(p, count, swap, d);
+  } else {
+    decode_items<int8_t>(p, count, swap, d);
+  }
+
+  // Missing values
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  if (type == 'i' && dt.byte_size == 4) {
+    for (size_t i = 0; i < count; i++) if (d[i] == (double)INT_MIN) d[i] = nan;
+  }
+  if (!std::isnan(na_value)) {
+    for (size_t i = 0; i < count; i++) if (d[i] == na_value) d[i] = nan;
+  }
+}
+
+void typed_scan::decode(size_t c, std::vector<uint8_t> &scratch,
+                        std::vector<double> &dest) const {
+  size_t start = chunk_start(c), count = chunk_length(c);
+  const uint8_t *p;
+  if (!flat.empty()) {
+    p = flat.data() + start * dt.byte_size;
+  } else {
+    scratch.resize(count * dt.byte_size);
+    blocks->decompress_block(c, scratch.data());
+    p = scratch.data();
+  }
+  dest.resize(count);
+  decode_values(p, count, dt, na_value, dest.data());
+}
+
+ext_section stats_section(const uint8_t *src, size_t nbytes, const blosc_dtype &dtype,
+                          size_t block_items) {
+  check_dtype(dtype);
+  size_t item = dtype.byte_size, n_items = nbytes / item;
+  size_t nblocks = n_items == 0 ? 0 : (n_items + block_items - 1) / block_items;
+  ext_section result;
+  result.id = EXT_STATS;
+  result.payload.resize(8 + nblocks * STATS_ENTRY_SIZE);
+  put_u64_le(result.payload.data(), (uint64_t)block_items);
+  uint8_t *out = result.payload.data() + 8;
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  std::vector<double> values;
+  for (size_t b = 0; b < nblocks; b++, out += STATS_ENTRY_SIZE) {
+    double mn = std::numeric_limits<double>::infinity(), mx = -mn;
+    uint64_t n_na = 0;
+    size_t end = std::min(n_items, (b + 1) * block_items);
+    // Large blocks are decoded in parts
+    for (size_t i = b * block_items; i < end; i += SCAN_CHUNK_ITEMS) {
+      size_t count = std::min((size_t)SCAN_CHUNK_ITEMS, end - i);
+      values.resize(count);
+      decode_values(src + i * item, count, dtype, nan, values.data());
+      for (double v : values) {
+        if (std::isnan(v)) {
+          n_na++;
+          continue;
+        }
+        mn = v < mn ? v : mn;
+        mx = v > mx ? v : mx;
+      }
+    }
+    put_f64_le(out, mn);
+    put_f64_le(out + 8, mx);
+    put_u64_le(out + 16, n_na);
+  }
+  return result;
+}
@@ -0,0 +1,100 @@
+#ifndef BLOSC_SCAN_H
+#define BLOSC_SCAN_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "blocks.h"
+#include "dtype.h"
+#include "header.h"
+
+// Minimum and maximum of the non-missing elements of a block, and its number
+// of missing elements. Blocks without non-missing elements have a minimum of
+// Inf and a maximum of -Inf.
+typedef struct {
+  double min;
+  double max;
+  uint64_t n_na;
+} block_stats;
+
+// Statistics of blocks can be recorded at compression time, in the
+// `EXT_STATS` section of the extension header (see `header.h`). Its payload
+// consists of the number of elements per block (uint64 LE), followed by the
+// minimum and maximum (float64 LE) and the number of missing elements
+// (uint64 LE) of each block. Only R's `NA` for 32 bit integers and NaN count
+// as missing, as values mapped to missing values are chosen at decompression.
+//
+// Computes the statistics of each `block_items` elements of the uncompressed
+// data at `src`, and returns them as an `EXT_STATS` section. Throws a
+// `std::runtime_error` when `dtype` cannot be scanned.
+ext_section stats_section(const uint8_t *src, size_t nbytes, const blosc_dtype &dtype,
+                          size_t block_items);
+
+// R type in which the value representing missing values of a scanned `dtype`
+// is given: like `dtype_rtype()`, except that 64 bit unsigned integers (which
+// R cannot decode) are scanned as doubles
+int scan_rtype(const blosc_dtype &dtype);
+
+// Decodes the elements of a compressed numeric buffer to doubles, one chunk
+// of elements at a time, such that it can be processed (for instance
+// reduced) without decompressing the entire buffer. Chunks correspond to
+// blosc blocks, which workers can decode in parallel with `decode()`.
+// Buffers with filters, or with blocks that split elements, are decompressed
+// entirely on construction instead.
+//
+// Boolean, integer and floating point dtypes of either byte order are
+// supported. Missing values (elements equal to `na`, and R's `NA` for 32 bit
+// integers) are decoded as NaN.
+class typed_scan {
+public:
+  // Should be called on the main thread. Throws a `std::runtime_error` when
+  // `src` cannot be scanned as `dtype`.
+  typed_scan(const uint8_t *src, size_t size, const blosc_dtype &dtype,
+             const blosc_na &na);
+
+  // Number of elements
+  size_t size() const {
+    return n_items;
+  }
+
+  size_t nchunks() const {
+    return n_chunks;
+  }
+
+  // Index of the first element of chunk `c`
+  size_t chunk_start(size_t c) const {
+    return c * chunk_items;
+  }
+
+  // Number of elements of chunk `c`
+  size_t chunk_length(size_t c) const {
+    return std::min(chunk_items, n_items - chunk_start(c));
+  }
+
+  // Statistics of chunk `c`, or `nullptr` when they were not recorded
+  const block_stats *chunk_stats(size_t c) const {
+    return stats.empty() ? nullptr : &stats[c];
+  }
+
+  // Whether elements equal to `na` are decoded as missing values
+  bool maps_na() const {
+    return !std::isnan(na_value);
+  }
+
+  // Decodes the elements of chunk `c` into `dest`. `scratch` is used for
+  // decompression, such that buffers can be reused between calls.
+  void decode(size_t c, std::vector<uint8_t> &scratch, std::vector<double> &dest) const;
+
+private:
+  blosc_dtype dt;
+  double na_value; // NaN when no values are mapped to missing values
+  std::unique_ptr<blosc_blocks> blocks;
+  std::vector<uint8_t> flat;
+  std::vector<block_stats> stats;
+  size_t n_items = 0;
+  size_t chunk_items = 0;
+  size_t n_chunks = 0;
+};
+
+#endif /* BLOSC_SCAN_H */
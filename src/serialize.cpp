@@ -0,0 +1,148 @@
+#include <cpp11.hpp>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include "container.h"
+
+using namespace cpp11;
+
+// R calls the stream callbacks below from its C code, through which C++
+// exceptions cannot be thrown. Errors are therefore recorded in the stream
+// state and raised as R errors, which `unwind_protect()` turns back into
+// C++ exceptions after R's code was left.
+typedef struct {
+  container_writer *writer;
+  container_reader *reader;
+  std::string error;
+} stream_state;
+
+static void out_bytes(R_outpstream_t stream, void *buf, int length) {
+  stream_state *state = (stream_state *)stream->data;
+  try {
+    state->writer->write((const uint8_t *)buf, (size_t)length);
+    return;
+  } catch (const std::exception &e) {
+    state->error = e.what();
+  }
+  Rf_error("%s", state->error.c_str());
+}
+
+static void out_char(R_outpstream_t stream, int c) {
+  uint8_t b = (uint8_t)c;
+  out_bytes(stream, &b, 1);
+}
+
+static void in_bytes(R_inpstream_t stream, void *buf, int length) {
+  stream_state *state = (stream_state *)stream->data;
+  try {
+    if (state->reader->read((uint8_t *)buf, (size_t)length) == (size_t)length) return;
+    state->error = "Unexpected end of blosc container";
+  } catch (const std::exception &e) {
+    state->error = e.what();
+  }
+  Rf_error("%s", state->error.c_str());
+}
+
+static int in_char(R_inpstream_t stream) {
+  uint8_t b;
+  in_bytes(stream, &b, 1);
+  return (int)b;
+}
+
+// Connections are written and read with `writeBin()` and `readBin()`. Their
+// errors are caught, such that they never unwind through C++ code.
+static container_sink connection_sink(SEXP con) {
+  return [con](const uint8_t *p, size_t n) {
+    SEXP data = PROTECT(Rf_allocVector(RAWSXP, (R_xlen_t)n));
+    memcpy(RAW(data), p, n);
+    SEXP call = PROTECT(Rf_lang3(Rf_install("writeBin"), data, con));
+    int failed = 0;
+    R_tryEvalSilent(call, R_BaseEnv, &failed);
+    UNPROTECT(2);
+    if (failed) throw std::runtime_error("Failed to write to connection");
+  };
+}
+
+static container_source connection_source(SEXP con) {
+  return [con](uint8_t *p, size_t n) {
+    size_t done = 0;
+    while (done < n) {
+      SEXP what = PROTECT(Rf_mkString("raw"));
+      SEXP size = PROTECT(Rf_ScalarReal((double)(n - done)));
+      SEXP call = PROTECT(Rf_lang4(Rf_install("readBin"), con, what, size));
+      int failed = 0;
+      SEXP data = PROTECT(R_tryEvalSilent(call, R_BaseEnv, &failed));
+      size_t len = failed ? 0 : (size_t)Rf_xlength(data);
+      if (len > 0) memcpy(p + done, RAW(data), len);
+      UNPROTECT(4);
+      if (failed) throw std::runtime_error("Failed to read from connection");
+      if (len == 0) break;
+      done += len;
+    }
+    return done;
+  };
+}
+
+[[cpp11::register]]
+SEXP blosc_serialize_(SEXP object, SEXP con, std::string path, bool xdr,
+                      std::string compressor, int level, int doshuffle,
+                      int typesize, double chunk_size, int nthreads) {
+  std::vector<uint8_t> memory;
+  std::unique_ptr<container_file> file;
+  container_sink sink;
+  if (!path.empty()) {
+    file.reset(new container_file(path, true));
+    sink = file->sink();
+  } else if (con != R_NilValue) {
+    sink = connection_sink(con);
+  } else {
+    sink = [&memory](const uint8_t *p, size_t n) {
+      memory.insert(memory.end(), p, p + n);
+    };
+  }
+  // Serialized data is compressed by workers as it is produced, so it is
+  // never held in memory as a whole
+  container_writer writer(sink, compressor, level, doshuffle, typesize,
+                          (size_t)chunk_size, nthreads);
+  stream_state state = {&writer, nullptr, ""};
+  struct R_outpstream_st stream;
+  R_InitOutPStream(&stream, (R_pstream_data_t)&state,
+                   xdr ? R_pstream_xdr_format : R_pstream_binary_format, 3,
+                   out_char, out_bytes, NULL, R_NilValue);
+  unwind_protect([&]() { R_Serialize(object, &stream); });
+  writer.finish();
+  if (file) file->close();
+  if (!path.empty() || con != R_NilValue) return R_NilValue;
+
+  writable::raws result((R_xlen_t)memory.size());
+  if (!memory.empty()) memcpy(RAW(as_sexp(result)), memory.data(), memory.size());
+  return result;
+}
+
+[[cpp11::register]]
+SEXP blosc_unserialize_(SEXP data, SEXP con, std::string path, int nthreads) {
+  std::unique_ptr<container_file> file;
+  container_source source;
+  size_t position = 0;
+  if (!path.empty()) {
+    file.reset(new container_file(path, false));
+    source = file->source();
+  } else if (con != R_NilValue) {
+    source = connection_source(con);
+  } else {
+    const uint8_t *src = (const uint8_t *)RAW(data);
+    size_t size = (size_t)Rf_xlength(data);
+    source = [src, size, &position](uint8_t *p, size_t n) {
+      size_t len = std::min(n, size - position);
+      memcpy(p, src + position, len);
+      position += len;
+      return len;
+    };
+  }
+  container_reader reader(source, nthreads);
+  stream_state state = {nullptr, &reader, ""};
+  struct R_inpstream_st stream;
+  R_InitInPStream(&stream, (R_pstream_data_t)&state, R_pstream_any_format,
+                  in_char, in_bytes, NULL, R_NilValue);
+  return unwind_protect([&]() { return R_Unserialize(&stream); });
+}
@@ -0,0 +1,136 @@
+#include <cpp11.hpp>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "dtype.h"
+#include "parallel.h"
+#include "scan.h"
+
+using namespace cpp11;
+
+enum which_op {
+  WHICH_GT, WHICH_GE, WHICH_LT, WHICH_LE, WHICH_EQ, WHICH_NE, WHICH_BETWEEN, WHICH_NA
+};
+
+static which_op parse_op(const std::string &op) {
+  if (op == ">") return WHICH_GT;
+  if (op == ">=") return WHICH_GE;
+  if (op == "<") return WHICH_LT;
+  if (op == "<=") return WHICH_LE;
+  if (op == "==") return WHICH_EQ;
+  if (op == "!=") return WHICH_NE;
+  if (op == "between") return WHICH_BETWEEN;
+  if (op == "is_na") return WHICH_NA;
+  stop("Unknown operator '%s'", op.c_str());
+}
+
+// Sets `match[i]` to 1 for the elements of `v` that satisfy `op`. Missing
+// values (NaN) never satisfy a comparison. Each operator has its own loop,
+// such that compilers can vectorise them.
+static void compare(const std::vector<double> &v, which_op op, double lower,
+                    double upper, std::vector<uint8_t> &match) {
+  size_t n = v.size();
+  match.resize(n);
+  const double *d = v.data();
+  uint8_t *m = match.data();
+  switch (op) {
+  case WHICH_GT: for (size_t i = 0; i < n; i++) m[i] = d[i] > lower; break;
+  case WHICH_GE: for (size_t i = 0; i < n; i++) m[i] = d[i] >= lower; break;
+  case WHICH_LT: for (size_t i = 0; i < n; i++) m[i] = d[i] < lower; break;
+  case WHICH_LE: for (size_t i = 0; i < n; i++) m[i] = d[i] <= lower; break;
+  case WHICH_EQ: for (size_t i = 0; i < n; i++) m[i] = d[i] == lower; break;
+  case WHICH_NE:
+    for (size_t i = 0; i < n; i++) m[i] = d[i] != lower && d[i] == d[i];
+    break;
+  case WHICH_BETWEEN:
+    for (size_t i = 0; i < n; i++) m[i] = d[i] >= lower && d[i] <= upper;
+    break;
+  case WHICH_NA: for (size_t i = 0; i < n; i++) m[i] = d[i] != d[i]; break;
+  }
+}
+
+// Whether no element of a chunk with statistics `s` can satisfy `op`, such
+// that it need not be decoded. Values mapped to missing values cannot match
+// a comparison either, so they only matter for "is_na".
+static bool cannot_match(const block_stats &s, which_op op, double lower,
+                         double upper, bool maps_na) {
+  switch (op) {
+  case WHICH_GT: return !(s.max > lower);
+  case WHICH_GE: return !(s.max >= lower);
+  case WHICH_LT: return !(s.min < lower);
+  case WHICH_LE: return !(s.min <= lower);
+  case WHICH_EQ: return !(lower >= s.min && lower <= s.max);
+  case WHICH_NE: return s.min > s.max || (s.min == lower && s.max == lower);
+  case WHICH_BETWEEN: return !(s.max >= lower && s.min <= upper);
+  case WHICH_NA: return s.n_na == 0 && !maps_na;
+  }
+  return false;
+}
+
+// Returns the (one-based) indices of matching elements, or a logical vector
+// when `logical` is set, in which missing elements are `NA` (unless `op` is
+// "is_na")
+[[cpp11::register]]
+SEXP blosc_which_(raws data, std::string dtype, std::string op, double lower,
+                  double upper, sexp na_value, bool logical, int nthreads) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  blosc_na na = resolve_na(na_value, scan_rtype(dt));
+  which_op wop = parse_op(op);
+  typed_scan scan((const uint8_t *)RAW(data), (size_t)data.size(), dt, na);
+  size_t nchunks = scan.nchunks();
+
+  if (logical) {
+    // Workers write directly into the memory of the result
+    writable::logicals result((R_xlen_t)scan.size());
+    int *dest = LOGICAL(as_sexp(result));
+    parallel_for(nchunks, nthreads, [&](size_t c) {
+      int *out = dest + scan.chunk_start(c);
+      // Skipped chunks should not contain missing values, which are `NA`
+      const block_stats *s = scan.chunk_stats(c);
+      if (s != nullptr && cannot_match(*s, wop, lower, upper, scan.maps_na()) &&
+          (wop == WHICH_NA || (s->n_na == 0 && !scan.maps_na()))) {
+        std::fill(out, out + scan.chunk_length(c), 0);
+        return;
+      }
+      std::vector<uint8_t> scratch, match;
+      std::vector<double> values;
+      scan.decode(c, scratch, values);
+      compare(values, wop, lower, upper, match);
+      for (size_t i = 0; i < values.size(); i++)
+        out[i] = wop != WHICH_NA && std::isnan(values[i]) ? NA_LOGICAL : (int)match[i];
+    });
+    return result;
+  }
+
+  // Indices are collected per chunk, and concatenated in order
+  std::vector<std::vector<double>> indices(nchunks);
+  parallel_for(nchunks, nthreads, [&](size_t c) {
+    const block_stats *s = scan.chunk_stats(c);
+    if (s != nullptr && cannot_match(*s, wop, lower, upper, scan.maps_na())) return;
+    std::vector<uint8_t> scratch, match;
+    std::vector<double> values;
+    scan.decode(c, scratch, values);
+    compare(values, wop, lower, upper, match);
+    double start = (double)scan.chunk_start(c) + 1;
+    for (size_t i = 0; i < match.size(); i++)
+      if (match[i]) indices[c].push_back(start + (double)i);
+  });
+  size_t total = 0;
+  for (const auto &idx : indices) total += idx.size();
+  if (scan.size() <= (size_t)INT_MAX) {
+    writable::integers result((R_xlen_t)total);
+    int *dest = INTEGER(as_sexp(result));
+    for (const auto &idx : indices)
+      for (double i : idx) *dest++ = (int)i;
+    return result;
+  }
+  writable::doubles result((R_xlen_t)total);
+  double *dest = REAL(as_sexp(result));
+  for (const auto &idx : indices) {
+    if (!idx.empty()) memcpy(dest, idx.data(), idx.size() * sizeof(double));
+    dest += idx.size();
+  }
+  return result;
+}
@@ -0,0 +1,811 @@
+#include <cpp11.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "dtype.h"
+#include "header.h"
+#include "parallel.h"
+#include "pipeline.h"
+
+using namespace cpp11;
+
+// Position of a selected element along one dimension: `out` is its position
+// in the resulting array, `inner` is its position within the chunk
+typedef struct {
+  int out;
+  int inner;
+} zarr_index;
+
+static void swap_bytes(uint8_t *data, int size) {
+  for (int i = 0; i < size / 2; i++) {
+    uint8_t b = data[i];
+    data[i] = data[size - i - 1];
+    data[size - i - 1] = b;
+  }
+}
+
+// Keeps track of where elements in a chunk should end up in the destination
+// R vector and decodes them. Everything R related is prepared on the main
+// thread, such that `fill()` and `decode()` can safely be called from workers.
+class zarr_target {
+public:
+  zarr_target(list selection, integers chunk_shape, std::string order,
+              blosc_dtype dtype, sexp fill, sexp na_value) : dt(dtype) {
+    ndim = (size_t)selection.size();
+    if ((size_t)chunk_shape.size() != ndim)
+      stop("Chunk shape does not match dimensions of selection");
+    rtype = dtype_rtype(dt);
+    raw_mode = rtype == STRSXP;
+    item_size = dtype_item_size(dt);
+    na = resolve_na(na_value, rtype == CPLXSXP ? REALSXP : rtype);
+    if (raw_mode) {
+      out_size = item_size;
+    } else if (rtype == LGLSXP || rtype == INTSXP) {
+      out_size = sizeof(int);
+    } else if (rtype == REALSXP) {
+      out_size = sizeof(double);
+    } else {
+      out_size = sizeof(Rcomplex);
+    }
+
+    chunk_items = 1;
+    n_out = 1;
+    index.resize(ndim);
+    chunk_stride.resize(ndim);
+    out_stride.resize(ndim);
+    for (size_t d = 0; d < ndim; d++) {
+      int cs = chunk_shape[d];
+      if (cs < 1) stop("Invalid chunk shape");
+      integers sel(selection[d]);
+      out_stride[d] = n_out;
+      n_out *= sel.size();
+      chunk_items *= cs;
+      for (int o = 0; o < (int)sel.size(); o++) {
+        int i = sel[o];
+        if (i < 0 || i == NA_INTEGER) stop("Invalid selection");
+        size_t c = (size_t)(i / cs);
+        if (c >= index[d].size()) index[d].resize(c + 1);
+        index[d][c].push_back({o, i % cs});
+      }
+    }
+    // Zarr chunks are stored in either C (row-major) or F (column-major) order
+    int64_t stride = 1;
+    c_order = order == "C";
+    if (c_order) {
+      for (size_t d = ndim; d-- > 0;) {
+        chunk_stride[d] = stride;
+        stride *= chunk_shape[d];
+      }
+    } else if (order == "F") {
+      for (size_t d = 0; d < ndim; d++) {
+        chunk_stride[d] = stride;
+        stride *= chunk_shape[d];
+      }
+    } else {
+      stop("Unknown order '%s'", order.c_str());
+    }
+
+    fill_value.assign(out_size, 0);
+    if (!Rf_isNull(fill)) {
+      raws fill_raw(fill);
+      if ((int)fill_raw.size() != item_size) stop("Invalid fill value");
+      std::vector<uint8_t> encoded(item_size);
+      memcpy(encoded.data(), RAW(fill_raw), item_size);
+      decode_element(encoded.data(), fill_value.data());
+    } else if (rtype == LGLSXP || rtype == INTSXP) {
+      // Without a fill value, elements in missing chunks are missing
+      int i = NA_INTEGER;
+      memcpy(fill_value.data(), &i, sizeof(int));
+    } else if (!raw_mode) {
+      double d = NA_REAL;
+      for (size_t p = 0; p < out_size; p += sizeof(double))
+        memcpy(fill_value.data() + p, &d, sizeof(double));
+    }
+  }
+
+  sexp allocate() {
+    sexp result = raw_mode ?
+      Rf_allocVector(RAWSXP, (R_xlen_t)(n_out * item_size)) :
+      Rf_allocVector(rtype, (R_xlen_t)n_out);
+    if (raw_mode) {
+      dest = (uint8_t *)RAW(result);
+    } else if (rtype == LGLSXP) {
+      dest = (uint8_t *)LOGICAL(result);
+    } else if (rtype == INTSXP) {
+      dest = (uint8_t *)INTEGER(result);
+    } else if (rtype == REALSXP) {
+      dest = (uint8_t *)REAL(result);
+    } else {
+      dest = (uint8_t *)COMPLEX(result);
+    }
+    return result;
+  }
+
+  sexp finish(sexp result, std::string dtype, sexp na_value) {
+    if (warn) warning("Data contains values equal to R's NA representation");
+    if (raw_mode) return dtype_to_r_(raws(result), dtype, na_value);
+    convert_time_units(result, dt, (R_xlen_t)n_out);
+    return result;
+  }
+
+  // Number of bytes of a decompressed chunk
+  size_t chunk_bytes() const {
+    return (size_t)chunk_items * item_size;
+  }
+
+  // Write the fill value to all selected positions of a missing chunk
+  void fill(const int *coords) {
+    for_each(coords, [&](int64_t, int64_t out) {
+      memcpy(dest + out * out_size, fill_value.data(), out_size);
+    });
+  }
+
+  // Decode the selected elements of a decompressed chunk
+  void decode(const int *coords, const uint8_t *chunk) {
+    for_each(coords, [&](int64_t src, int64_t out) {
+      decode_element(chunk + src * item_size, dest + out * out_size);
+    });
+  }
+
+  // Decompress (when `compressed`) and decode an encoded chunk. `data` may be
+  // modified in the process.
+  void decode_encoded(const int *coords, uint8_t *data, size_t size,
+                      bool compressed, const std::string &name) {
+    size_t nbytes = chunk_bytes();
+    if (!compressed) {
+      if (size != nbytes)
+        throw std::runtime_error("Unexpected size of chunk '" + name + "'");
+      decode(coords, data);
+      return;
+    }
+    size_t decomp_size = 0;
+    if (backend_cbuffer_validate(data, size, &decomp_size) < 0 || decomp_size != nbytes)
+      throw std::runtime_error("Chunk '" + name + "' is not a valid blosc buffer");
+    std::vector<uint8_t> chunk(nbytes);
+    if (backend_decompress(data, size, chunk.data(), nbytes, 1) < 0)
+      throw std::runtime_error("Failed to decompress chunk '" + name + "'");
+    decode(coords, chunk.data());
+  }
+
+  // Whether any elements are selected in chunk `coord` along dimension `d`
+  bool selected(size_t d, int coord) const {
+    return coord >= 0 && (size_t)coord < index[d].size() && !index[d][coord].empty();
+  }
+
+private:
+  blosc_dtype dt;
+  blosc_na na;
+  int rtype;
+  bool raw_mode;
+  int item_size;
+  size_t out_size;
+  size_t ndim;
+  bool c_order;
+  int64_t chunk_items;
+  int64_t n_out;
+  std::vector<std::vector<std::vector<zarr_index>>> index;
+  std::vector<int64_t> chunk_stride;
+  std::vector<int64_t> out_stride;
+  std::vector<uint8_t> fill_value;
+  uint8_t *dest = nullptr;
+  std::atomic<bool> warn{false};
+
+  void decode_element(const uint8_t *src, uint8_t *out) {
+    if (raw_mode) {
+      memcpy(out, src, item_size);
+      return;
+    }
+    int parts = rtype == CPLXSXP ? 2 : 1;
+    int part_size = item_size / parts;
+    int part_rtype = rtype == CPLXSXP ? REALSXP : rtype;
+    size_t part_out = out_size / parts;
+    for (int p = 0; p < parts; p++) {
+      conversion_t conv;
+      memset(&conv, 0, sizeof(complex64));
+      memcpy(&conv, src + p * part_size, part_size);
+      if (dt.needs_byteswap) swap_bytes((uint8_t *)&conv, part_size);
+      if (convert_data_inv(&conv, dt, part_rtype, out + p * part_out, na))
+        warn = true;
+    }
+  }
+
+  // Call `fn(src, out)` for each selected element in the chunk at `coords`,
+  // where `src` is the element offset in the chunk and `out` the element
+  // offset in the destination.
+  template <typename F>
+  void for_each(const int *coords, F fn) {
+    std::vector<const std::vector<zarr_index> *> sel(ndim);
+    for (size_t d = 0; d < ndim; d++) {
+      if (coords[d] < 0 || (size_t)coords[d] >= index[d].size()) return;
+      sel[d] = &index[d][coords[d]];
+      if (sel[d]->empty()) return;
+    }
+    std::vector<size_t> pos(ndim, 0);
+    while (true) {
+      int64_t src = 0, out = 0;
+      for (size_t d = 0; d < ndim; d++) {
+        const zarr_index &zi = (*sel[d])[pos[d]];
+        src += zi.inner * chunk_stride[d];
+        out += zi.out * out_stride[d];
+      }
+      fn(src, out);
+      // Advance along the dimension that is contiguous in the chunk first
+      size_t k = 0;
+      for (; k < ndim; k++) {
+        size_t d = c_order ? ndim - 1 - k : k;
+        if (++pos[d] < sel[d]->size()) break;
+        pos[d] = 0;
+      }
+      if (k == ndim) break;
+    }
+  }
+};
+
+// Reads an entire file into `buffer`. Returns `false` when the file does not
+// exist (i.e. the chunk was never written).
+static bool read_chunk_file(const std::string &path, std::vector<uint8_t> &buffer) {
+  FILE *f = std::fopen(path.c_str(), "rb");
+  if (f == nullptr) {
+    if (errno == ENOENT) return false;
+    throw std::runtime_error("Failed to open chunk file '" + path + "'");
+  }
+  bool ok = std::fseek(f, 0, SEEK_END) == 0;
+  long size = ok ? std::ftell(f) : -1;
+  ok = size >= 0 && std::fseek(f, 0, SEEK_SET) == 0;
+  if (ok) {
+    buffer.resize((size_t)size);
+    ok = std::fread(buffer.data(), 1, (size_t)size, f) == (size_t)size;
+  }
+  std::fclose(f);
+  if (!ok) throw std::runtime_error("Failed to read chunk file '" + path + "'");
+  return true;
+}
+
+[[cpp11::register]]
+sexp zarr_read_chunks_(strings chunk_files, integers chunk_coords, list selection,
+                       integers chunk_shape, std::string dtype, std::string order,
+                       bool compressed, sexp fill, sexp na_value, int nthreads) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  zarr_target target(selection, chunk_shape, order, dt, fill, na_value);
+  sexp result = target.allocate();
+
+  size_t n_chunks = (size_t)chunk_files.size();
+  size_t ndim = (size_t)selection.size();
+  if ((size_t)chunk_coords.size() != n_chunks * ndim)
+    stop("Chunk coordinates do not match the number of chunks");
+  std::vector<std::string> files(n_chunks);
+  for (size_t i = 0; i < n_chunks; i++) files[i] = std::string(chunk_files[i]);
+  // Coordinates are passed as a column-major matrix with a row for each chunk
+  std::vector<int> coords(n_chunks * ndim);
+  for (size_t i = 0; i < n_chunks; i++)
+    for (size_t d = 0; d < ndim; d++)
+      coords[i * ndim + d] = chunk_coords[d * n_chunks + i];
+  parallel_for(n_chunks, nthreads, [&](size_t i) {
+    std::vector<uint8_t> data;
+    const int *cc = coords.data() + i * ndim;
+    if (read_chunk_file(files[i], data)) {
+      target.decode_encoded(cc, data.data(), data.size(), compressed, files[i]);
+    } else {
+      target.fill(cc);
+    }
+  });
+
+  return target.finish(result, dtype, na_value);
+}
+
+// Provides positioned reads on a file, such that multiple threads can read
+// different parts of the same file without sharing a file position.
+class positional_file {
+public:
+  explicit positional_file(const std::string &path) : path(path) {
+#ifdef _WIN32
+    f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+      if (errno == ENOENT) return;
+      throw std::runtime_error("Failed to open shard file '" + path + "'");
+    }
+    if (_fseeki64(f, 0, SEEK_END) != 0 || (file_size = _ftelli64(f)) < 0)
+      throw std::runtime_error("Failed to read shard file '" + path + "'");
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      if (errno == ENOENT) return;
+      throw std::runtime_error("Failed to open shard file '" + path + "'");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+      throw std::runtime_error("Failed to read shard file '" + path + "'");
+    file_size = (int64_t)st.st_size;
+#endif
+  }
+
+  ~positional_file() {
+#ifdef _WIN32
+    if (f != nullptr) std::fclose(f);
+#else
+    if (fd >= 0) ::close(fd);
+#endif
+  }
+
+  positional_file(const positional_file&) = delete;
+  positional_file& operator=(const positional_file&) = delete;
+
+  // `false` when the file does not exist (i.e. the shard was never written)
+  bool exists() const {
+#ifdef _WIN32
+    return f != nullptr;
+#else
+    return fd >= 0;
+#endif
+  }
+
+  int64_t size() const {
+    return file_size;
+  }
+
+  void read(int64_t offset, size_t n, uint8_t *dest) {
+    if (offset < 0 || offset + (int64_t)n > file_size)
+      throw std::runtime_error("Read beyond the end of shard file '" + path + "'");
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(mtx);
+    if (_fseeki64(f, offset, SEEK_SET) != 0 || std::fread(dest, 1, n, f) != n)
+      throw std::runtime_error("Failed to read shard file '" + path + "'");
+#else
+    while (n > 0) {
+      ssize_t r = ::pread(fd, dest, n, (off_t)offset);
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) throw std::runtime_error("Failed to read shard file '" + path + "'");
+      dest += r;
+      offset += r;
+      n -= (size_t)r;
+    }
+#endif
+  }
+
+private:
+  std::string path;
+  int64_t file_size = 0;
+#ifdef _WIN32
+  FILE *f = nullptr;
+  std::mutex mtx;
+#else
+  int fd = -1;
+#endif
+};
+
+// CRC-32C (Castagnoli), used to checksum shard indices
+static uint32_t crc32c(const uint8_t *data, size_t n) {
+  static const std::vector<uint32_t> table = []() {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < n; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFFu;
+}
+
+static const uint64_t SHARD_EMPTY = ~(uint64_t)0;
+
+// An inner chunk that needs to be read from a shard
+typedef struct {
+  size_t shard;
+  uint64_t offset;
+  uint64_t nbytes;
+  std::vector<int> coords;
+} shard_task;
+
+[[cpp11::register]]
+sexp zarr_read_shards_(strings shard_files, integers shard_coords, list selection,
+                       integers shard_shape, integers inner_shape, std::string dtype,
+                       bool compressed, bool index_at_end, bool index_crc,
+                       sexp fill, sexp na_value, int nthreads) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  // Zarr v3 chunks are always stored in C order
+  zarr_target target(selection, inner_shape, "C", dt, fill, na_value);
+  sexp result = target.allocate();
+
+  size_t n_shards = (size_t)shard_files.size();
+  size_t ndim = (size_t)selection.size();
+  if ((size_t)shard_coords.size() != n_shards * ndim)
+    stop("Shard coordinates do not match the number of shards");
+  if ((size_t)shard_shape.size() != ndim || (size_t)inner_shape.size() != ndim)
+    stop("Shard shape does not match dimensions of selection");
+  std::vector<int> per_shard(ndim);
+  size_t n_inner = 1;
+  for (size_t d = 0; d < ndim; d++) {
+    if (inner_shape[d] < 1 || shard_shape[d] % inner_shape[d] != 0)
+      stop("Shard shape should be a multiple of the inner chunk shape");
+    per_shard[d] = shard_shape[d] / inner_shape[d];
+    n_inner *= (size_t)per_shard[d];
+  }
+  size_t index_size = n_inner * 16 + (index_crc ? 4 : 0);
+  std::vector<std::string> files(n_shards);
+  for (size_t i = 0; i < n_shards; i++) files[i] = std::string(shard_files[i]);
+
+  // Shards are processed in batches, to limit the number of open files
+  const size_t batch_size = 256;
+  for (size_t first = 0; first < n_shards; first += batch_size) {
+    size_t n_batch = std::min(batch_size, n_shards - first);
+    std::vector<std::unique_ptr<positional_file>> handles(n_batch);
+    std::vector<std::vector<shard_task>> tasks(n_batch);
+
+    // Read the index of each shard and collect the inner chunks that
+    // intersect with the selection
+    parallel_for(n_batch, nthreads, [&](size_t b) {
+      size_t s = first + b;
+      handles[b].reset(new positional_file(files[s]));
+      positional_file &pf = *handles[b];
+      std::vector<int> sc(ndim), local(ndim, 0), cc(ndim);
+      for (size_t d = 0; d < ndim; d++) sc[d] = shard_coords[d * n_shards + s];
+
+      std::vector<uint8_t> index;
+      if (pf.exists()) {
+        if (pf.size() < (int64_t)index_size)
+          throw std::runtime_error("Shard file '" + files[s] + "' is too small");
+        index.resize(index_size);
+        pf.read(index_at_end ? pf.size() - (int64_t)index_size : 0, index_size,
+                index.data());
+        if (index_crc) {
+          uint32_t expected = get_u32_le(index.data() + n_inner * 16);
+          if (crc32c(index.data(), n_inner * 16) != expected)
+            throw std::runtime_error("Checksum mismatch in index of shard '" + files[s] + "'");
+        }
+      }
+      // Inner chunks are indexed in C order
+      for (size_t k = 0; k < n_inner; k++) {
+        bool hit = true;
+        for (size_t d = 0; d < ndim && hit; d++) {
+          cc[d] = sc[d] * per_shard[d] + local[d];
+          hit = target.selected(d, cc[d]);
+        }
+        if (hit) {
+          uint64_t offset = SHARD_EMPTY, nbytes = SHARD_EMPTY;
+          if (!index.empty()) {
+            offset = get_u64_le(index.data() + k * 16);
+            nbytes = get_u64_le(index.data() + k * 16 + 8);
+          }
+          if (offset == SHARD_EMPTY && nbytes == SHARD_EMPTY) {
+            target.fill(cc.data());
+          } else {
+            tasks[b].push_back({b, offset, nbytes, cc});
+          }
+        }
+        for (size_t j = ndim; j-- > 0;) {
+          if (++local[j] < per_shard[j]) break;
+          local[j] = 0;
+        }
+      }
+    });
+
+    // Read and decode only the selected inner chunks
+    std::vector<const shard_task *> all_tasks;
+    for (auto &t : tasks) for (auto &task : t) all_tasks.push_back(&task);
+    parallel_for(all_tasks.size(), nthreads, [&](size_t i) {
+      const shard_task &task = *all_tasks[i];
+      if (task.nbytes > (uint64_t)BACKEND_MAX_BUFFERSIZE + BACKEND_MAX_OVERHEAD)
+        throw std::runtime_error("Invalid index in shard '" + files[first + task.shard] + "'");
+      std::vector<uint8_t> data((size_t)task.nbytes);
+      handles[task.shard]->read((int64_t)task.offset, data.size(), data.data());
+      target.decode_encoded(task.coords.data(), data.data(), data.size(), compressed,
+                            files[first + task.shard]);
+    });
+  }
+
+  return target.finish(result, dtype, na_value);
+}
+
+static void write_chunk_file(const std::string &path, const uint8_t *data, size_t size) {
+  FILE *f = std::fopen(path.c_str(), "wb");
+  if (f == nullptr)
+    throw std::runtime_error("Failed to open chunk file '" + path + "' for writing");
+  bool ok = std::fwrite(data, 1, size, f) == size;
+  ok = std::fclose(f) == 0 && ok;
+  if (!ok) throw std::runtime_error("Failed to write chunk file '" + path + "'");
+}
+
+// Gathers chunks from an R array and encodes them to the target data type.
+// Unlike `zarr_target`, it uses the R API and can only be used on the main
+// thread.
+class zarr_source {
+public:
+  zarr_source(sexp data, integers shape, integers chunk_shape, std::string order,
+              blosc_dtype dtype, sexp fill, sexp na_value) :
+  dt(dtype), na_value(na_value) {
+    rtype = dtype_rtype(dt);
+    item_size = dtype_item_size(dt);
+    ndim = (size_t)shape.size();
+    if ((size_t)chunk_shape.size() != ndim)
+      stop("Chunk shape does not match dimensions of data");
+    if (order != "C" && order != "F") stop("Unknown order '%s'", order.c_str());
+    c_order = order == "C";
+
+    // R arrays are stored in column-major order
+    x_stride.resize(ndim);
+    x_shape.resize(ndim);
+    c_shape.resize(ndim);
+    R_xlen_t x_size = 1;
+    chunk_items = 1;
+    for (size_t d = 0; d < ndim; d++) {
+      x_stride[d] = x_size;
+      x_shape[d] = shape[d];
+      c_shape[d] = chunk_shape[d];
+      x_size *= shape[d];
+      chunk_items *= chunk_shape[d];
+    }
+    if (Rf_xlength(data) != x_size) stop("Length of data does not match its shape");
+    if ((double)chunk_items * item_size > (double)BACKEND_MAX_BUFFERSIZE)
+      stop("Chunks are too large, use a smaller chunk shape");
+
+    dat = Rf_coerceVector(data, rtype);
+    if (rtype == LGLSXP) {
+      r_size = sizeof(int);
+      src = (const uint8_t *)LOGICAL(dat);
+    } else if (rtype == INTSXP) {
+      r_size = sizeof(int);
+      src = (const uint8_t *)INTEGER(dat);
+    } else if (rtype == REALSXP) {
+      r_size = sizeof(double);
+      src = (const uint8_t *)REAL(dat);
+    } else if (rtype == CPLXSXP) {
+      r_size = sizeof(Rcomplex);
+      src = (const uint8_t *)COMPLEX(dat);
+    }
+
+    // Padding of edge chunks consists of the fill value
+    has_fill = !Rf_isNull(fill);
+    fill_r.assign(r_size > 0 ? r_size : 1, 0);
+    fill_enc.assign(item_size, 0);
+    fill_dat = has_fill ? Rf_coerceVector(fill, rtype) : R_NilValue;
+    if (has_fill) {
+      if (Rf_xlength(fill_dat) != 1) stop("Fill value should have a length of 1");
+      if (r_size > 0) memcpy(fill_r.data(), DATAPTR_RO(fill_dat), r_size);
+      convert_data(fill_r.data(), fill_dat, rtype, 1, dt, fill_enc.data(), na_value);
+      if (dt.needs_byteswap) byte_swap(fill_enc.data(), dt, 1);
+    }
+    staging.resize((size_t)chunk_items * (r_size > 0 ? r_size : 1));
+  }
+
+  // Number of bytes of an encoded chunk
+  size_t chunk_bytes() const {
+    return (size_t)chunk_items * item_size;
+  }
+
+  int get_item_size() const {
+    return item_size;
+  }
+
+  // Whether any encoded value was equal to the value representing missing values
+  bool warned() const {
+    return warn;
+  }
+
+  // Encode the chunk at `coords` into `out` (`chunk_bytes()` long). Returns
+  // `false` when the chunk consists of fill values only.
+  bool encode(const int *coords, uint8_t *out) {
+    writable::strings staging_str(rtype == STRSXP ? chunk_items : 0);
+    std::vector<int> inner(ndim, 0);
+    // Gather the chunk's elements in the chunk's storage order
+    for (R_xlen_t k = 0; k < chunk_items; k++) {
+      bool inside = true;
+      R_xlen_t xi = 0;
+      for (size_t d = 0; d < ndim; d++) {
+        int64_t g = (int64_t)coords[d] * c_shape[d] + inner[d];
+        if (g >= x_shape[d]) {
+          inside = false;
+          break;
+        }
+        xi += (R_xlen_t)g * x_stride[d];
+      }
+      if (rtype == STRSXP) {
+        SEXP s = inside ? STRING_ELT(dat, xi) :
+          (has_fill ? STRING_ELT(fill_dat, 0) : NA_STRING);
+        SET_STRING_ELT(staging_str, k, s);
+      } else if (inside) {
+        memcpy(staging.data() + k * r_size, src + xi * r_size, r_size);
+      } else {
+        memcpy(staging.data() + k * r_size, fill_r.data(), r_size);
+      }
+      for (size_t j = 0; j < ndim; j++) {
+        size_t d = c_order ? ndim - 1 - j : j;
+        if (++inner[d] < c_shape[d]) break;
+        inner[d] = 0;
+      }
+    }
+
+    if (convert_data(staging.data(), staging_str, rtype, (int)chunk_items, dt,
+                     out, na_value)) warn = true;
+    if (dt.needs_byteswap) byte_swap(out, dt, (uint32_t)chunk_items);
+
+    if (!has_fill) return true;
+    for (R_xlen_t k = 0; k < chunk_items; k++)
+      if (memcmp(out + k * item_size, fill_enc.data(), item_size) != 0) return true;
+    return false;
+  }
+
+private:
+  blosc_dtype dt;
+  sexp na_value;
+  int rtype;
+  int item_size;
+  size_t ndim;
+  bool c_order;
+  R_xlen_t chunk_items;
+  std::vector<R_xlen_t> x_stride;
+  std::vector<int64_t> x_shape;
+  std::vector<int> c_shape;
+  sexp dat;
+  size_t r_size = 0;
+  const uint8_t *src = nullptr;
+  bool has_fill;
+  sexp fill_dat;
+  std::vector<uint8_t> fill_r;
+  std::vector<uint8_t> fill_enc;
+  std::vector<uint8_t> staging;
+  bool warn = false;
+};
+
+// Compresses `size` bytes of `data`, throws (rather than calling R's `stop()`)
+// as it is called from worker threads
+static size_t compress_chunk(const uint8_t *data, size_t size, uint8_t *dest,
+                             int level, int doshuffle, int item_size,
+                             const std::string &compressor, int blocksize) {
+  int out = backend_compress(level, doshuffle, item_size, size, data, dest,
+                             size + BACKEND_MAX_OVERHEAD, compressor.c_str(),
+                             blocksize, 1);
+  if (out <= 0) throw std::runtime_error("BLOSC compressor failed!");
+  return (size_t)out;
+}
+
+[[cpp11::register]]
+int zarr_write_chunks_(sexp data, integers shape, strings chunk_files,
+                       integers chunk_coords, integers chunk_shape, std::string dtype,
+                       std::string order, bool compressed, std::string compressor,
+                       int level, int doshuffle, int blocksize, sexp fill,
+                       sexp na_value, int nthreads) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  zarr_source source(data, shape, chunk_shape, order, dt, fill, na_value);
+  int item_size = source.get_item_size();
+  size_t ndim = (size_t)shape.size();
+  size_t n_chunks = (size_t)chunk_files.size();
+  if ((size_t)chunk_coords.size() != n_chunks * ndim)
+    stop("Chunk coordinates do not match the number of chunks");
+
+  int written = 0;
+  task_queue queue(nthreads, 2 * (size_t)(nthreads < 1 ? 1 : nthreads));
+  std::vector<int> coords(ndim);
+  for (size_t i = 0; i < n_chunks; i++) {
+    for (size_t d = 0; d < ndim; d++) coords[d] = chunk_coords[d * n_chunks + i];
+    auto encoded = std::make_shared<std::vector<uint8_t>>(source.chunk_bytes());
+    std::string path(chunk_files[i]);
+    if (!source.encode(coords.data(), encoded->data())) {
+      // Chunks consisting of fill values only are not stored
+      std::remove(path.c_str());
+      continue;
+    }
+
+    written++;
+    queue.submit([=]() {
+      if (!compressed) {
+        write_chunk_file(path, encoded->data(), encoded->size());
+        return;
+      }
+      std::vector<uint8_t> dest(encoded->size() + BACKEND_MAX_OVERHEAD);
+      size_t out = compress_chunk(encoded->data(), encoded->size(), dest.data(),
+                                  level, doshuffle, item_size, compressor, blocksize);
+      write_chunk_file(path, dest.data(), out);
+    });
+  }
+  queue.wait();
+  if (source.warned())
+    warning("Data contains values equal to the value representing missing values!");
+  return written;
+}
+
+[[cpp11::register]]
+int zarr_write_shards_(sexp data, integers shape, strings shard_files,
+                       integers shard_coords, integers shard_shape,
+                       integers inner_shape, std::string dtype, bool compressed,
+                       std::string compressor, int level, int doshuffle,
+                       int blocksize, sexp fill, sexp na_value, int nthreads) {
+  blosc_dtype dt = prepare_dtype(dtype);
+  // Zarr v3 chunks are always stored in C order
+  zarr_source source(data, shape, inner_shape, "C", dt, fill, na_value);
+  int item_size = source.get_item_size();
+  size_t ndim = (size_t)shape.size();
+  size_t n_shards = (size_t)shard_files.size();
+  if ((size_t)shard_coords.size() != n_shards * ndim)
+    stop("Shard coordinates do not match the number of shards");
+  if ((size_t)shard_shape.size() != ndim)
+    stop("Shard shape does not match dimensions of data");
+  std::vector<int> per_shard(ndim);
+  size_t n_inner = 1;
+  for (size_t d = 0; d < ndim; d++) {
+    if (shard_shape[d] % inner_shape[d] != 0)
+      stop("Shard shape should be a multiple of the inner chunk shape");
+    per_shard[d] = shard_shape[d] / inner_shape[d];
+    n_inner *= (size_t)per_shard[d];
+  }
+  size_t chunk_bytes = source.chunk_bytes();
+
+  int written = 0;
+  task_queue queue(nthreads, 2 * (size_t)(nthreads < 1 ? 1 : nthreads));
+  std::vector<int> local(ndim), cc(ndim);
+  for (size_t s = 0; s < n_shards; s++) {
+    // Encode all inner chunks of the shard (in C order) on the main thread,
+    // an empty vector marks an inner chunk that only holds fill values
+    auto encoded = std::make_shared<std::vector<std::vector<uint8_t>>>(n_inner);
+    std::fill(local.begin(), local.end(), 0);
+    bool empty = true;
+    std::vector<uint8_t> buffer(chunk_bytes);
+    for (size_t k = 0; k < n_inner; k++) {
+      bool inside = true;
+      for (size_t d = 0; d < ndim; d++) {
+        cc[d] = shard_coords[d * n_shards + s] * per_shard[d] + local[d];
+        if ((int64_t)cc[d] * inner_shape[d] >= shape[d]) inside = false;
+      }
+      if (inside && source.encode(cc.data(), buffer.data())) {
+        (*encoded)[k].swap(buffer);
+        buffer.resize(chunk_bytes);
+        empty = false;
+      }
+      for (size_t j = ndim; j-- > 0;) {
+        if (++local[j] < per_shard[j]) break;
+        local[j] = 0;
+      }
+    }
+
+    std::string path(shard_files[s]);
+    if (empty) {
+      // Shards consisting of fill values only are not stored
+      std::remove(path.c_str());
+      continue;
+    }
+
+    written++;
+    queue.submit([=]() {
+      std::vector<uint8_t> shard;
+      std::vector<uint8_t> index(n_inner * 16 + 4);
+      std::vector<uint8_t> dest(compressed ? chunk_bytes + BACKEND_MAX_OVERHEAD : 0);
+      for (size_t k = 0; k < n_inner; k++) {
+        const std::vector<uint8_t> &chunk = (*encoded)[k];
+        if (chunk.empty()) {
+          put_u64_le(index.data() + k * 16, SHARD_EMPTY);
+          put_u64_le(index.data() + k * 16 + 8, SHARD_EMPTY);
+          continue;
+        }
+        const uint8_t *out = chunk.data();
+        size_t n = chunk.size();
+        if (compressed) {
+          n = compress_chunk(chunk.data(), chunk.size(), dest.data(), level,
+                             doshuffle, item_size, compressor, blocksize);
+          out = dest.data();
+        }
+        put_u64_le(index.data() + k * 16, (uint64_t)shard.size());
+        put_u64_le(index.data() + k * 16 + 8, (uint64_t)n);
+        shard.insert(shard.end(), out, out + n);
+      }
+      // The index (followed by its checksum) is stored at the end of the shard
+      put_u32_le(index.data() + n_inner * 16, crc32c(index.data(), n_inner * 16));
+      shard.insert(shard.end(), index.begin(), index.end());
+      write_chunk_file(path, shard.data(), shard.size());
+    });
+  }
+  queue.wait();
+  if (source.warned())
+    warning("Data contains values equal to the value representing missing values!");
+  return written;
+}